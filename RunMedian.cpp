@@ -1,263 +1,1910 @@
-#include <iostream>
-#include "include/runmedian.hpp"
-#include <gtest/gtest.h>
-
-#define RANDOM50() (uint16_t)(rand() % 51)
-#define RANDOM3000() (uint16_t)(rand() % 3001)
-
-#define GTEST_COUT std::cerr << "[          ] [ ERROR ]"
-
-void HandleError() { std::cerr << "HandleError was called"; }
-
-TEST(RunMedianTests, Size) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    ASSERT_EQ(0U, q.Size());
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-
-    q.Add(RANDOM50());
-    ASSERT_EQ(1U, q.Size());
-
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    ASSERT_TRUE(q._check_integrity());
-    ASSERT_EQ(5U, q.Size());
-    std::cerr << "Running median: " << q.Value() << std::endl;
-
-    q.Add(RANDOM50());
-    ASSERT_TRUE(q._check_integrity());
-    ASSERT_EQ(5U, q.Size());
-    std::cerr << "Running median: " << q.Value() << std::endl;
-
-    q.Add(RANDOM50());
-    ASSERT_TRUE(q._check_integrity());
-    std::cerr << "Running median: " << q.Value() << std::endl;
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-TEST(RunMedianTests, Median4TestGrowing) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    q.Add(1);
-    ASSERT_EQ(1, q.Value());
-
-    q.Add(2);
-    ASSERT_EQ(1, q.Value());
-
-    q.Add(3);
-    ASSERT_EQ(2, q.Value());
-
-    q.Add(4);
-    ASSERT_EQ(2, q.Value());
-
-    q.Add(5);
-    ASSERT_EQ(3, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(6);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(7);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-TEST(RunMedianTests, Median4TestDecreasing) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    q.Add(7);
-    ASSERT_EQ(7, q.Value());
-
-    q.Add(6);
-    ASSERT_EQ(6, q.Value());
-
-    q.Add(5);
-    ASSERT_EQ(6, q.Value());
-
-    q.Add(4);
-    ASSERT_EQ(5, q.Value());
-
-    q.Add(3);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(2);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(1);
-    ASSERT_EQ(3, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-TEST(RunMedianTests, Median5TestDiff) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    q.Add(7);
-    ASSERT_EQ(7, q.Value());
-
-    q.Add(1);
-    // std::cerr << q.Value() << std::endl;
-    ASSERT_EQ(4, q.Value());
-
-    q.Add(5);
-    ASSERT_EQ(5, q.Value());
-
-    q.Add(2);
-    ASSERT_EQ(3, q.Value());
-
-    q.Add(6);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(3);
-    ASSERT_EQ(3, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(5);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_EQ(5U, q.Size());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(10);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_EQ(5U, q.Size());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(1);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_EQ(5U, q.Size());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(4);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_EQ(5U, q.Size());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-TEST(RunMedianTests, RandomTest) {
-    common::Runmedian<uint16_t, 19> q{};
-    q.RegisterCallbacks(HandleError);
-
-    for (int i = 0; i < 2000; i++) {
-        q.Add(RANDOM3000());
-        ASSERT_TRUE(q._check_integrity());
-    }
-}
-
-TEST(RunMedianTests, FullArrayTest) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    q.Add(7);
-    ASSERT_EQ(7, q.Value());
-
-    q.Add(1);
-    // std::cerr << q.Value() << std::endl;
-    ASSERT_EQ(4, q.Value());
-
-    q.Add(5);
-    ASSERT_EQ(5, q.Value());
-    ASSERT_EQ(3, q.Size());
-
-    q.Add(4);
-    ASSERT_EQ(4, q.Value());
-
-    q.Add(3);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(2);
-    ASSERT_EQ(3, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(6);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(7);
-    ASSERT_EQ(4, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(8);
-    ASSERT_EQ(6, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(2);
-    ASSERT_EQ(6, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(10);
-    ASSERT_EQ(7, q.Value());
-    ASSERT_TRUE(q._check_integrity());
-
-    q.Add(1);
-    ASSERT_EQ(7, q.Value());
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-TEST(RunMedianTests, DeleteAll) {
-    common::Runmedian<uint16_t, 5> q{};
-    q.RegisterCallbacks(HandleError);
-
-    ASSERT_EQ(0U, q.Size());
-
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    q.Add(RANDOM50());
-    ASSERT_TRUE(q._check_integrity());
-
-    ASSERT_EQ(5U, q.Size());
-    std::cerr << "Running median: " << q.Value() << std::endl;
-
-    q.Add(RANDOM50());
-    ASSERT_EQ(5U, q.Size());
-    ASSERT_TRUE(q._check_integrity());
-    std::cerr << "Running median: " << q.Value() << std::endl;
-
-    q.Clear();
-    ASSERT_EQ(0U, q.Size());
-    ASSERT_EQ(0U, q.Value());
-}
-
-int main(int argc, char** argv) {
-    ::testing::InitGoogleTest(&argc, argv);
-    srand((unsigned int)time(NULL));
-    return RUN_ALL_TESTS();
-}
-
-//int main()
-//{
-//    common::Runmedian<int, 8> rm;
-//    rm.Add(1);
-//    std::cout << "Hello World!\n" << rm.Value() << std::endl;
-//}
+#include <iostream>
+#include "include/hampel.hpp"
+#include "include/medfilter.hpp"
+#include "include/medfilter2d.hpp"
+#include "include/remedian.hpp"
+#include "include/rmcheckpoint.hpp"
+#include "include/rmtrace.hpp"
+#include "include/rqueue.hpp"
+#include "include/runextremes.hpp"
+#include "include/runmedian.hpp"
+#include "include/runmedianbank.hpp"
+#include "include/runmedianhistogram.hpp"
+#include "include/runmedianhop.hpp"
+#include "include/runmedianlarge.hpp"
+#include "include/runmedianregistry.hpp"
+#include "include/runmedianspsc.hpp"
+#include "include/runmediantimed.hpp"
+#include "include/runmedianview.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#define RANDOM50() (uint16_t)(rand() % 51)
+#define RANDOM3000() (uint16_t)(rand() % 3001)
+
+#define GTEST_COUT std::cerr << "[          ] [ ERROR ]"
+
+void HandleError() { std::cerr << "HandleError was called"; }
+
+TEST(RunMedianTests, Size) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    ASSERT_EQ(0U, q.Size());
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+
+    q.Add(RANDOM50());
+    ASSERT_EQ(1U, q.Size());
+
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    ASSERT_TRUE(q._check_integrity());
+    ASSERT_EQ(5U, q.Size());
+    std::cerr << "Running median: " << q.Value() << std::endl;
+
+    q.Add(RANDOM50());
+    ASSERT_TRUE(q._check_integrity());
+    ASSERT_EQ(5U, q.Size());
+    std::cerr << "Running median: " << q.Value() << std::endl;
+
+    q.Add(RANDOM50());
+    ASSERT_TRUE(q._check_integrity());
+    std::cerr << "Running median: " << q.Value() << std::endl;
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, Median4TestGrowing) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    q.Add(1);
+    ASSERT_EQ(1, q.Value());
+
+    q.Add(2);
+    ASSERT_EQ(1, q.Value());
+
+    q.Add(3);
+    ASSERT_EQ(2, q.Value());
+
+    q.Add(4);
+    ASSERT_EQ(2, q.Value());
+
+    q.Add(5);
+    ASSERT_EQ(3, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(6);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(7);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, Median4TestDecreasing) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    q.Add(7);
+    ASSERT_EQ(7, q.Value());
+
+    q.Add(6);
+    ASSERT_EQ(6, q.Value());
+
+    q.Add(5);
+    ASSERT_EQ(6, q.Value());
+
+    q.Add(4);
+    ASSERT_EQ(5, q.Value());
+
+    q.Add(3);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(2);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(1);
+    ASSERT_EQ(3, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, Median5TestDiff) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    q.Add(7);
+    ASSERT_EQ(7, q.Value());
+
+    q.Add(1);
+    // std::cerr << q.Value() << std::endl;
+    ASSERT_EQ(4, q.Value());
+
+    q.Add(5);
+    ASSERT_EQ(5, q.Value());
+
+    q.Add(2);
+    ASSERT_EQ(3, q.Value());
+
+    q.Add(6);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(3);
+    ASSERT_EQ(3, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(5);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_EQ(5U, q.Size());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(10);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_EQ(5U, q.Size());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(1);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_EQ(5U, q.Size());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(4);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_EQ(5U, q.Size());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, RandomTest) {
+    common::Runmedian<uint16_t, 19> q{};
+    q.RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 2000; i++) {
+        q.Add(RANDOM3000());
+        ASSERT_TRUE(q._check_integrity());
+    }
+}
+
+TEST(RunMedianTests, FullArrayTest) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    q.Add(7);
+    ASSERT_EQ(7, q.Value());
+
+    q.Add(1);
+    // std::cerr << q.Value() << std::endl;
+    ASSERT_EQ(4, q.Value());
+
+    q.Add(5);
+    ASSERT_EQ(5, q.Value());
+    ASSERT_EQ(3, q.Size());
+
+    q.Add(4);
+    ASSERT_EQ(4, q.Value());
+
+    q.Add(3);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(2);
+    ASSERT_EQ(3, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(6);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(7);
+    ASSERT_EQ(4, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(8);
+    ASSERT_EQ(6, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(2);
+    ASSERT_EQ(6, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(10);
+    ASSERT_EQ(7, q.Value());
+    ASSERT_TRUE(q._check_integrity());
+
+    q.Add(1);
+    ASSERT_EQ(7, q.Value());
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, DeleteAll) {
+    common::Runmedian<uint16_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+
+    ASSERT_EQ(0U, q.Size());
+
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    q.Add(RANDOM50());
+    ASSERT_TRUE(q._check_integrity());
+
+    ASSERT_EQ(5U, q.Size());
+    std::cerr << "Running median: " << q.Value() << std::endl;
+
+    q.Add(RANDOM50());
+    ASSERT_EQ(5U, q.Size());
+    ASSERT_TRUE(q._check_integrity());
+    std::cerr << "Running median: " << q.Value() << std::endl;
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Size());
+    ASSERT_EQ(0U, q.Value());
+}
+
+TEST(RunMedianTests, AddBatch) {
+    common::Runmedian<uint16_t, 19> q{};
+    common::Runmedian<uint16_t, 19> batch{};
+    q.RegisterCallbacks(HandleError);
+    batch.RegisterCallbacks(HandleError);
+
+    std::vector<uint16_t> data(1000);
+    for (auto& val : data)
+        val = RANDOM3000();
+
+    std::vector<uint16_t> medians(data.size());
+    batch.AddBatch(data.data(), 10, medians.data());
+    batch.AddBatch(data.data() + 10, 500);
+    batch.AddBatch(data.data() + 510, data.size() - 510, medians.data() + 510);
+    batch.AddBatch(nullptr, 0);
+
+    for (size_t i = 0; i < data.size(); i++) {
+        q.Add(data[i]);
+        if (i < 10 || i >= 510) {
+            ASSERT_EQ(q.Value(), medians[i]);
+        }
+    }
+    ASSERT_TRUE(batch._check_integrity());
+    ASSERT_EQ(q.Size(), batch.Size());
+    ASSERT_EQ(q.Value(), batch.Value());
+}
+
+TEST(RunMedianTests, Quantiles) {
+    common::Runmedian<uint16_t, 19> q{};
+    q.RegisterCallbacks(HandleError);
+    std::vector<uint16_t> stream;
+    const double quantiles[] = {0.0, 0.5, 0.9, 0.99, 1.0};
+
+    for (int i = 0; i < 500; i++) {
+        const uint16_t val = RANDOM3000();
+        stream.push_back(val);
+        q.Add(val);
+
+        const size_t count = std::min(stream.size(), (size_t)19);
+        std::vector<uint16_t> window(stream.end() - count, stream.end());
+        std::sort(window.begin(), window.end());
+
+        ASSERT_EQ(window.front(), q.Rank(0));
+        ASSERT_EQ(window.back(), q.Rank((uint8_t)(count - 1)));
+        ASSERT_EQ(window.front(), q.Quantile(0.0));
+        ASSERT_EQ(window.back(), q.Quantile(1.0));
+        ASSERT_EQ(window[(size_t)(0.9 * (count - 1) + 0.5)], q.Quantile(0.9));
+        if (count % 2) {
+            ASSERT_EQ(q.Value(), q.Quantile(0.5));
+        }
+
+        uint16_t multi[5];
+        q.Quantiles(quantiles, 5, multi);
+        uint16_t fixed[5];
+        q.Quantiles<0, 500, 900, 990, 1000>(fixed);
+        for (size_t j = 0; j < 5; j++) {
+            ASSERT_EQ(q.Quantile(quantiles[j]), multi[j]);
+            ASSERT_EQ(multi[j], fixed[j]);
+        }
+    }
+
+    q.Clear();
+    ASSERT_EQ(0U, q.Quantile(0.5));
+}
+
+template <typename TMedian, uint16_t... kPermille>
+void FixedQuantiles(const TMedian& q, uint16_t* out, std::integer_sequence<uint16_t, kPermille...>) {
+    q.template Quantiles<kPermille...>(out);
+}
+
+TEST(RunMedianTests, QuantilesSameRanks) {
+    // Quantile(p / 1000) and Quantiles<p>() take the same rank for every per mille and every size
+    auto q = std::make_unique<common::Runmedian<uint16_t, 255, common::NoLock, common::IgnoreError>>();
+    std::vector<uint16_t> fixed(1001);
+
+    for (uint16_t i = 0; i < 300; i++) {
+        // growing values, so the value is its rank while the window is not full
+        q->Add(i);
+        const uint32_t count = q->Size();
+        FixedQuantiles(*q, fixed.data(), std::make_integer_sequence<uint16_t, 1001>{});
+        for (uint32_t permille = 0; permille <= 1000U; permille++) {
+            ASSERT_EQ(fixed[permille], q->Quantile(permille / 1000.0)) << count << " " << permille;
+            ASSERT_EQ(q->Rank((uint8_t)((permille * (count - 1U) + 500U) / 1000U)), fixed[permille]);
+        }
+    }
+
+    // 0.58 * 25 is 14.5 exactly, but double 0.58 is a bit less than it
+    common::Runmedian<uint16_t, 26, common::NoLock, common::IgnoreError> r{};
+    for (uint16_t i = 0; i < 26; i++) {
+        r.Add(i);
+    }
+    uint16_t rank[1];
+    r.Quantiles<580>(rank);
+    ASSERT_EQ(15U, rank[0]);
+    ASSERT_EQ(15U, r.Quantile(0.58));
+}
+
+TEST(RunMedianTests, Policies) {
+    // no locks and no error handling leave only the data
+    using Bare = common::Runmedian<uint8_t, 5, common::NoLock, common::IgnoreError>;
+    ASSERT_EQ(sizeof(uint8_t) * 5 + 5 + 2, sizeof(Bare));
+    // values are stored once, with one byte of order index per value
+    ASSERT_EQ(sizeof(int32_t) * 19 + 19 + 2 + 3, sizeof(common::Runmedian<int32_t, 19, common::NoLock, common::IgnoreError>));
+
+    Bare bare{};
+    common::Runmedian<uint8_t, 5, common::StdMutex> with_mutex{};
+    common::Runmedian<uint8_t, 5, common::SpinLock, common::IgnoreError> with_spin{};
+    common::Runmedian<uint8_t, 5, common::NoLock> with_error{};
+    with_error.RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 100; i++) {
+        const uint8_t val = (uint8_t)RANDOM50();
+        bare.Add(val);
+        with_mutex.Add(val);
+        with_spin.Add(val);
+        with_error.Add(val);
+        ASSERT_EQ(bare.Value(), with_mutex.Value());
+        ASSERT_EQ(bare.Value(), with_spin.Value());
+        ASSERT_EQ(bare.Value(), with_error.Value());
+    }
+
+    // rank out of range is an error
+    ASSERT_EQ(0U, with_error.Rank(5));
+
+    common::Runmedian<uint16_t, 19, common::SpinLock> shared{};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&shared]() {
+            for (int i = 0; i < 10000; i++)
+                shared.Add(RANDOM3000());
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    ASSERT_TRUE(shared._check_integrity());
+}
+
+template <typename T, uint8_t kSize> void CheckWithLarge(int range) {
+    common::Runmedian<T, kSize> q{};
+    auto large = std::make_unique<common::RunmedianLarge<T, kSize>>();
+    q.RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 3000; i++) {
+        // few distinct values to have a lot of duplicates
+        const T val = (T)(rand() % range);
+        q.Add(val);
+        large->Add(val);
+        ASSERT_TRUE(q._check_integrity());
+        ASSERT_EQ(q.Value(), large->Value());
+    }
+}
+
+TEST(RunMedianTests, Checkpoint) {
+    using Engine = common::Runmedian<uint16_t, 19, common::NoLock, common::IgnoreError>;
+    using TinyEngine = common::Runmedian<float, 5, common::NoLock, common::IgnoreError>;
+    const size_t kEngines = 1000;
+
+    std::vector<Engine> engines(kEngines);
+    std::vector<TinyEngine> tiny(kEngines);
+    for (size_t i = 0; i < kEngines; i++) {
+        // windows are full, partly filled or empty
+        for (size_t j = 0; j < i % 40U; j++) {
+            engines[i].Add(RANDOM3000());
+            tiny[i].Add((float)RANDOM50());
+        }
+    }
+
+    std::vector<uint64_t> buffer(common::CheckpointSize<Engine>(kEngines) / sizeof(uint64_t) + 1U);
+    const size_t size = buffer.size() * sizeof(uint64_t);
+    ASSERT_EQ(common::CheckpointSize<Engine>(kEngines),
+              common::SaveCheckpoint(engines.data(), kEngines, buffer.data(), size));
+    ASSERT_EQ(0U, common::SaveCheckpoint(engines.data(), kEngines, buffer.data(), size / 2U));
+
+    std::vector<Engine> restored(kEngines);
+    ASSERT_TRUE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines, true));
+    size_t mapped_count = 0;
+    Engine* mapped = common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count);
+    ASSERT_NE(nullptr, mapped);
+    ASSERT_EQ(kEngines, mapped_count);
+
+    // restored and mapped engines go on as the original ones
+    for (size_t i = 0; i < kEngines; i++) {
+        ASSERT_EQ(engines[i].Size(), restored[i].Size());
+        ASSERT_EQ(engines[i].Value(), mapped[i].Value());
+        for (int j = 0; j < 25; j++) {
+            const uint16_t val = RANDOM3000();
+            engines[i].Add(val);
+            restored[i].Add(val);
+            mapped[i].Add(val);
+            ASSERT_EQ(engines[i].Value(), restored[i].Value());
+            ASSERT_EQ(engines[i].Value(), mapped[i].Value());
+        }
+        ASSERT_TRUE(mapped[i]._check_integrity());
+    }
+
+    // tiny windows keep values themselves
+    std::vector<uint8_t> tiny_buffer(common::CheckpointSize<TinyEngine>(kEngines));
+    ASSERT_NE(0U, common::SaveCheckpoint(tiny.data(), kEngines, tiny_buffer.data(), tiny_buffer.size()));
+    std::vector<TinyEngine> tiny_restored(kEngines);
+    ASSERT_TRUE(common::LoadCheckpoint(tiny_buffer.data(), tiny_buffer.size(), tiny_restored.data(), kEngines, true));
+    for (size_t i = 0; i < kEngines; i++) {
+        tiny[i].Add(7.0f);
+        tiny_restored[i].Add(7.0f);
+        ASSERT_EQ(tiny[i].Value(), tiny_restored[i].Value());
+    }
+
+    // other engine type, count, size or version are rejected
+    ASSERT_FALSE(common::LoadCheckpoint(tiny_buffer.data(), tiny_buffer.size(), restored.data(), kEngines));
+    ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines - 1U));
+    ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size - sizeof(Engine) * 2U, restored.data(), kEngines));
+    ASSERT_EQ(nullptr, common::MapCheckpoint<TinyEngine>(buffer.data(), size, &mapped_count));
+    common::CheckpointHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    header.version++;
+    memcpy(buffer.data(), &header, sizeof(header));
+    ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines));
+}
+
+TEST(RunMedianTests, CheckpointCorrupted) {
+    using Engine = common::Runmedian<uint16_t, 19, common::NoLock, common::IgnoreError>;
+    const size_t kEngines = 4;
+
+    std::vector<Engine> engines(kEngines);
+    for (size_t i = 0; i < kEngines; i++) {
+        for (size_t j = 0; j < 25U - i * 5U; j++) {
+            engines[i].Add(RANDOM3000());
+        }
+    }
+    std::vector<uint64_t> saved(common::CheckpointSize<Engine>(kEngines) / sizeof(uint64_t) + 1U);
+    const size_t size = saved.size() * sizeof(uint64_t);
+    ASSERT_NE(0U, common::SaveCheckpoint(engines.data(), kEngines, saved.data(), size));
+
+    // engine state is values, positions, count and head, the last engine (not full window) is damaged
+    const size_t last = sizeof(common::CheckpointHeader) + (kEngines - 1U) * sizeof(Engine);
+    const size_t positions = last + sizeof(uint16_t) * 19U;
+    const size_t count_at = positions + 19U;
+    const size_t head_at = count_at + 1U;
+    ASSERT_EQ(engines.back().Size(), reinterpret_cast<const uint8_t*>(saved.data())[count_at]);
+    const std::pair<size_t, uint8_t> damages[] = {
+        {count_at, 20U},  // count above the window
+        {count_at, 255U}, // torn write
+        {head_at, 19U},   // head outside of the window
+        {head_at, 3U},    // head of not full window
+        {positions, 30U}, // position outside of the window
+    };
+
+    std::vector<Engine> restored(kEngines);
+    size_t mapped_count = 0;
+    std::vector<uint64_t> buffer(saved.size());
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(buffer.data());
+    for (const auto& damage : damages) {
+        buffer = saved;
+        bytes[damage.first] = damage.second;
+        ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines)) << damage.first;
+        ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines, true));
+        ASSERT_EQ(nullptr, common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count)) << damage.first;
+        ASSERT_EQ(nullptr, common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count, true));
+    }
+
+    // positions in bounds but not a permutation pass the cheap check and are caught by the full one
+    buffer = saved;
+    bytes[positions + 1U] = bytes[positions];
+    ASSERT_TRUE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines));
+    ASSERT_FALSE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines, true));
+    ASSERT_NE(nullptr, common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count));
+    ASSERT_EQ(nullptr, common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count, true));
+
+    // not damaged checkpoint is accepted by both checks
+    buffer = saved;
+    ASSERT_TRUE(common::LoadCheckpoint(buffer.data(), size, restored.data(), kEngines, true));
+    ASSERT_NE(nullptr, common::MapCheckpoint<Engine>(buffer.data(), size, &mapped_count, true));
+    ASSERT_EQ(kEngines, mapped_count);
+}
+
+TEST(RunMedianTests, Stats) {
+    static_assert(sizeof(common::Runmedian<int, 30, common::NoLock, common::IgnoreError>) ==
+                      sizeof(common::Runmedian<int, 30, common::NoLock, common::IgnoreError, common::NoStats>),
+                  "NoStats has no storage");
+
+    common::Runmedian<int, 30, common::StdMutex, common::IgnoreError, common::InstanceStats> q{};
+    // rising values are inserted at the end, nothing is shifted until the window is full
+    for (int i = 0; i < 30; i++)
+        q.Add(i);
+    common::StatsCounters stats = q.Stats();
+    ASSERT_EQ(30U, stats.adds);
+    ASSERT_EQ(0U, stats.shifted);
+    ASSERT_EQ(29U * 30U / 2U, stats.compared);
+    ASSERT_EQ(30U, stats.locks);
+    ASSERT_LE(stats.lock_ticks_max, stats.lock_ticks);
+
+    // then the oldest value is the first one, all others are shifted to erase it
+    for (int i = 30; i < 100; i++)
+        q.Add(i);
+    stats = q.Stats();
+    ASSERT_EQ(100U, stats.adds);
+    ASSERT_EQ(70U * 29U, stats.shifted);
+    ASSERT_EQ(29U * 30U / 2U + 70U * 30U, stats.compared);
+
+    // falling values are inserted at the begin, the oldest value is i-th one
+    for (int i = 0; i < 10; i++)
+        q.Add(-i);
+    q.Value();
+    stats = q.Stats();
+    ASSERT_EQ(110U, stats.adds);
+    ASSERT_EQ(70U * 29U + 45U, stats.shifted);
+    ASSERT_EQ(111U, stats.locks);
+
+    // tiny windows count comparators of the sorting network
+    common::Runmedian<float, 5, common::NoLock, common::IgnoreError, common::InstanceStats> tiny{};
+    const float values[3] = {1.0f, 2.0f, 3.0f};
+    tiny.AddBatch(values, 3);
+    stats = tiny.Stats();
+    ASSERT_EQ(3U, stats.adds);
+    ASSERT_EQ(3U * 10U, stats.compared);
+    ASSERT_EQ(1U, stats.locks);
+
+    // thread counters are shared by containers at a thread
+    using ThreadCounted = common::Runmedian<uint16_t, 19, common::NoLock, common::IgnoreError, common::ThreadStats>;
+    common::ThreadStats::Reset();
+    ThreadCounted a{};
+    ThreadCounted b{};
+    a.Add(1);
+    b.Add(2);
+    b.Add(3);
+    ASSERT_EQ(3U, a.Stats().adds);
+    std::thread other([&b]() {
+        common::ThreadStats::Reset();
+        ASSERT_EQ(0U, b.Stats().adds);
+        b.Add(4);
+        ASSERT_EQ(1U, b.Stats().adds);
+    });
+    other.join();
+    ASSERT_EQ(3U, b.Stats().adds);
+}
+
+TEST(RunMedianTests, VectorTypesTest) {
+    CheckWithLarge<uint8_t, 255>(256);
+    CheckWithLarge<uint8_t, 40>(7);
+    CheckWithLarge<uint16_t, 64>(3001);
+    CheckWithLarge<uint16_t, 33>(5);
+    CheckWithLarge<int32_t, 64>(3001);
+    CheckWithLarge<int32_t, 19>(3);
+    CheckWithLarge<float, 64>(3001);
+    CheckWithLarge<double, 64>(3001);
+}
+
+template <typename T, uint8_t kSize> void CheckWithSort(int range) {
+    common::Runmedian<T, kSize> q{};
+    std::vector<T> stream;
+    q.RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 1000; i++) {
+        const T val = (T)(rand() % range);
+        stream.push_back(val);
+        q.Add(val);
+        ASSERT_TRUE(q._check_integrity());
+
+        const size_t count = std::min(stream.size(), (size_t)kSize);
+        std::vector<T> window(stream.end() - count, stream.end());
+        std::sort(window.begin(), window.end());
+        const T expected = (count % 2) ? window[count / 2]
+                                       : common::detail::Midpoint(window[count / 2 - 1], window[count / 2]);
+        ASSERT_EQ(count, q.Size());
+        ASSERT_EQ(expected, q.Value());
+    }
+}
+
+TEST(RunMedianTests, TinyWindows) {
+    // sorting network windows, including warm-up of every one
+    CheckWithSort<uint16_t, 1>(3001);
+    CheckWithSort<uint16_t, 2>(3001);
+    CheckWithSort<uint16_t, 3>(5);
+    CheckWithSort<uint16_t, 4>(3001);
+    CheckWithSort<uint16_t, 5>(3);
+    CheckWithSort<int32_t, 6>(3001);
+    CheckWithSort<int32_t, 7>(4);
+    CheckWithSort<float, 8>(3001);
+    CheckWithSort<double, 9>(3001);
+    CheckWithSort<uint8_t, 9>(256);
+
+    // ranks come from the same sorted array
+    common::Runmedian<int32_t, 5> q{};
+    q.RegisterCallbacks(HandleError);
+    const int32_t values[] = {7, -3, 12, 7, 0, 5, -3};
+    for (const int32_t val : values)
+        q.Add(val);
+    ASSERT_EQ(-3, q.Rank(0));
+    ASSERT_EQ(0, q.Rank(1));
+    ASSERT_EQ(5, q.Rank(2));
+    ASSERT_EQ(7, q.Rank(3));
+    ASSERT_EQ(12, q.Rank(4));
+    ASSERT_EQ(5, q.Value());
+}
+
+// median and median absolute deviation of a window by sorting, deviations are values of T as for Runmedian::Mad()
+template <typename T> std::pair<T, T> SortedMedianMad(std::vector<T> window) {
+    std::sort(window.begin(), window.end());
+    const size_t count = window.size();
+    const T median =
+        (count % 2) ? window[count / 2] : common::detail::Midpoint(window[count / 2 - 1], window[count / 2]);
+    for (auto& val : window)
+        val = (T)(val < median ? median - val : val - median);
+    std::sort(window.begin(), window.end());
+    const T mad = (count % 2) ? window[count / 2] : common::detail::Midpoint(window[count / 2 - 1], window[count / 2]);
+    return {median, mad};
+}
+
+template <typename T, uint8_t kSize> void CheckMad(int range) {
+    common::Runmedian<T, kSize> q{};
+    std::vector<T> stream;
+    q.RegisterCallbacks(HandleError);
+    ASSERT_EQ(T{}, q.Mad());
+
+    for (int i = 0; i < 1000; i++) {
+        const T val = (T)(rand() % range);
+        stream.push_back(val);
+        q.Add(val);
+
+        const size_t count = std::min(stream.size(), (size_t)kSize);
+        const auto expected = SortedMedianMad(std::vector<T>(stream.end() - count, stream.end()));
+        ASSERT_EQ(expected.first, q.Value());
+        ASSERT_EQ(expected.second, q.Mad());
+    }
+}
+
+TEST(RunMedianTests, Mad) {
+    CheckMad<uint16_t, 1>(3001);
+    CheckMad<uint16_t, 2>(3001);
+    CheckMad<uint16_t, 5>(3001);
+    CheckMad<int32_t, 8>(51);
+    CheckMad<uint16_t, 19>(3001);
+    CheckMad<uint8_t, 40>(7);
+    CheckMad<uint8_t, 255>(256);
+    CheckMad<int32_t, 64>(3001);
+    CheckMad<float, 64>(3001);
+    CheckMad<double, 33>(3);
+}
+
+TEST(RunMedianLargeTests, SameAsRunmedian) {
+    common::Runmedian<uint16_t, 19> q{};
+    auto large = std::make_unique<common::RunmedianLarge<uint16_t, 19>>();
+    q.RegisterCallbacks(HandleError);
+    large->RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 2000; i++) {
+        const uint16_t val = RANDOM50();
+        q.Add(val);
+        large->Add(val);
+        ASSERT_TRUE(large->_check_integrity());
+        ASSERT_EQ(q.Size(), large->Size());
+        ASSERT_EQ(q.Value(), large->Value());
+    }
+
+    large->Clear();
+    ASSERT_TRUE(large->IsEmpty());
+    ASSERT_EQ(0U, large->Value());
+}
+
+TEST(RunMedianLargeTests, BigWindow) {
+    constexpr uint32_t kWindow = 10000;
+    auto large = std::make_unique<common::RunmedianLarge<int32_t, kWindow>>();
+    large->RegisterCallbacks(HandleError);
+    std::vector<int32_t> stream;
+
+    for (int i = 0; i < 3 * (int)kWindow; i++) {
+        const int32_t val = (int32_t)(rand() % 200001) - 100000;
+        stream.push_back(val);
+        large->Add(val);
+
+        if (i % 997 == 0 || i == 3 * (int)kWindow - 1) {
+            ASSERT_TRUE(large->_check_integrity());
+            const size_t count = std::min(stream.size(), (size_t)kWindow);
+            std::vector<int32_t> window(stream.end() - count, stream.end());
+            std::sort(window.begin(), window.end());
+            const int32_t expected = (count % 2) ? window[count / 2]
+                                                 : (int32_t)((window[count / 2 - 1] + window[count / 2]) >> 1);
+            ASSERT_EQ(count, large->Size());
+            ASSERT_EQ(expected, large->Value());
+        }
+    }
+}
+
+template <typename T, uint8_t kSize, uint32_t kBins> void CheckHistogram(uint32_t range) {
+    common::Runmedian<T, kSize> q{};
+    auto histogram = std::make_unique<common::RunmedianHistogram<T, kSize, kBins>>();
+    histogram->RegisterCallbacks(HandleError);
+
+    for (int i = 0; i < 3000; i++) {
+        // jumps between far values make the cursor skip a lot of empty bins
+        const T val = (T)((i % 500 < 250) ? rand() % range : kBins - 1U - rand() % range);
+        q.Add(val);
+        histogram->Add(val);
+        ASSERT_TRUE(histogram->_check_integrity());
+        ASSERT_EQ(q.Size(), histogram->Size());
+        ASSERT_EQ(q.Value(), histogram->Value());
+    }
+}
+
+TEST(RunMedianHistogramTests, SameAsRunmedian) {
+    CheckHistogram<uint8_t, 255, 256>(256);
+    CheckHistogram<uint8_t, 40, 256>(4);
+    CheckHistogram<uint8_t, 1, 256>(256);
+    CheckHistogram<uint16_t, 64, 1024>(1024);
+    CheckHistogram<uint16_t, 100, 4096>(30);
+    CheckHistogram<uint16_t, 255, 4096>(4096);
+
+    common::RunmedianHistogram<uint16_t, 5> histogram{};
+    common::RunmedianHistogram<uint16_t, 5> batch{};
+    const uint16_t values[] = {4095, 0, 17, 17, 3000, 2, 2};
+    uint16_t medians[sizeof(values) / sizeof(values[0])];
+    batch.AddBatch(values, sizeof(values) / sizeof(values[0]), medians);
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        histogram.Add(values[i]);
+        ASSERT_EQ(histogram.Value(), medians[i]);
+    }
+
+    // values out of bins are dropped
+    histogram.Add(4096);
+    ASSERT_EQ(5U, histogram.Size());
+    ASSERT_EQ(17U, histogram.Value());
+
+    histogram.Clear();
+    ASSERT_TRUE(histogram.IsEmpty());
+    ASSERT_TRUE(histogram._check_integrity());
+    ASSERT_EQ(0U, histogram.Value());
+}
+
+template <typename TTime, uint8_t kSize> void CheckTimed(TTime start, TTime horizon, uint32_t max_gap) {
+    common::RunmedianTimed<uint16_t, kSize, TTime> q(horizon);
+    std::deque<std::pair<uint16_t, TTime>> window; // brute force reference
+    TTime now = start;
+
+    auto expire = [&window, horizon](TTime at) {
+        while (!window.empty() && (TTime)(at - window.front().second) >= horizon)
+            window.pop_front();
+    };
+    auto median = [&window]() {
+        std::vector<uint16_t> sorted;
+        for (const auto& item : window)
+            sorted.push_back(item.first);
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.empty())
+            return (uint16_t)0;
+        const size_t index = (sorted.size() - 1U) / 2U;
+        return sorted.size() % 2U ? sorted[index] : common::detail::Midpoint(sorted[index], sorted[index + 1U]);
+    };
+
+    for (int i = 0; i < 20000; i++) {
+        // bursts of values at the same time and long pauses, which expire many values at once
+        now = (TTime)(now + (rand() % 8 == 0 ? rand() % (max_gap * 4U) : rand() % max_gap));
+        const uint16_t val = RANDOM3000();
+        q.Add(val, now);
+        expire(now);
+        if (window.size() == kSize)
+            window.pop_front();
+        window.emplace_back(val, now);
+
+        ASSERT_TRUE(q._check_integrity());
+        ASSERT_EQ(window.size(), q.Size());
+        if (rand() % 4 == 0) {
+            const TTime later = (TTime)(now + rand() % max_gap);
+            expire(later);
+            ASSERT_EQ(median(), q.Value(later));
+            ASSERT_EQ(window.size(), q.Size());
+            ASSERT_TRUE(q._check_integrity());
+            now = later;
+        } else {
+            ASSERT_EQ(median(), q.Value(now));
+        }
+    }
+}
+
+TEST(RunMedianTimedTests, SameAsSort) {
+    CheckTimed<uint32_t, 255>(0U, 500U, 20U);
+    CheckTimed<uint32_t, 19>(0U, 500U, 40U);
+    CheckTimed<uint32_t, 5>(0U, 30U, 10U);
+    CheckTimed<uint32_t, 1>(0U, 30U, 10U);
+    // counter wraps around a few times
+    CheckTimed<uint16_t, 64>(65000U, 1000U, 30U);
+
+    common::RunmedianTimed<int, 10, uint32_t, common::NoLock, common::IgnoreError> q(100U);
+    q.Add(5, 1000U);
+    q.Add(7, 1050U);
+    ASSERT_EQ(6, q.Value(1099U));
+    ASSERT_EQ(7, q.Value(1100U));
+    // earlier timestamps are errors
+    q.Add(1, 1000U);
+    ASSERT_EQ(1U, q.Size());
+    ASSERT_EQ(0U, q.Expire(1010U));
+    ASSERT_EQ(1U, q.Expire(1150U));
+    ASSERT_TRUE(q.IsEmpty());
+    ASSERT_EQ(0, q.Value(1200U));
+    q.Add(3, 2000U);
+    q.Clear();
+    ASSERT_TRUE(q.IsEmpty());
+}
+
+template <typename T, uint8_t kBase, uint8_t kLevels> void CheckRemedianBound(const std::vector<T>& data) {
+    using Engine = common::Remedian<T, kBase, kLevels>;
+    auto q = std::make_unique<Engine>();
+    const size_t window = (size_t)Engine::kWindow;
+    const size_t block = window / kBase;
+    // values of the window not greater and not less than the value
+    size_t bound = 1U;
+    for (uint8_t i = 0; i < kLevels; i++)
+        bound *= (kBase + 1U) / 2U;
+
+    for (size_t i = 0; i < data.size(); i++) {
+        q->Add(data[i]);
+        ASSERT_EQ(std::min(i + 1U, window), q->Size());
+        if ((i + 1U) % block != 0U || i + 1U < window)
+            continue;
+
+        ASSERT_TRUE(q->_check_integrity());
+        const T val = q->Value();
+        const auto begin = data.begin() + (ptrdiff_t)(i + 1U - window);
+        const auto end = data.begin() + (ptrdiff_t)(i + 1U);
+        const size_t not_greater = (size_t)std::count_if(begin, end, [val](T x) { return !(val < x); });
+        const size_t not_less = (size_t)std::count_if(begin, end, [val](T x) { return !(x < val); });
+        ASSERT_GE(not_greater, bound);
+        ASSERT_GE(not_less, bound);
+        // the same bound as a fraction of the window
+        ASSERT_LE(0.5 - (double)bound / window, Engine::RankErrorBound() + 1e-12);
+    }
+}
+
+TEST(RemedianTests, RankErrorBound) {
+    std::vector<uint16_t> data(40000);
+    for (auto& val : data)
+        val = RANDOM3000();
+    CheckRemedianBound<uint16_t, 5, 3>(data);
+    CheckRemedianBound<uint16_t, 15, 3>(data);
+
+    // sorted blocks are the worst case for the remedian
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint16_t)(i % 77U);
+    CheckRemedianBound<uint16_t, 5, 3>(data);
+    CheckRemedianBound<uint16_t, 7, 4>(data);
+
+    std::vector<float> floats(10000);
+    for (auto& val : floats)
+        val = (float)RANDOM3000() / 7.0f;
+    CheckRemedianBound<float, 9, 2>(floats);
+
+    // one level is Runmedian
+    common::Remedian<int, 7, 1> one{};
+    common::Runmedian<int, 7> exact{};
+    for (int i = 0; i < 1000; i++) {
+        const int val = RANDOM50();
+        one.Add(val);
+        exact.Add(val);
+        ASSERT_EQ(exact.Value(), one.Value());
+    }
+    one.Clear();
+    ASSERT_TRUE(one.IsEmpty());
+    ASSERT_EQ(0, one.Value());
+
+    static_assert(common::Remedian<uint16_t, 15, 3>::kWindow == 3375U, "15^3 values");
+    ASSERT_LT((common::Remedian<uint16_t, 15, 3>::Footprint()), 200U);
+}
+
+template <typename T, uint8_t kSize, uint8_t kHop> void CheckHop(uint32_t range) {
+    common::Runmedian<T, kSize> expected{};
+    common::RunmedianHop<T, kSize, kHop> hop{};
+    common::RunmedianHop<T, kSize, kHop> batch{};
+    std::vector<T> data(3000);
+    for (auto& val : data)
+        val = (T)(rand() % range);
+
+    std::vector<T> medians;
+    for (size_t i = 0; i < data.size(); i++) {
+        expected.Add(data[i]);
+        hop.Add(data[i]);
+        // a median is needed every kHop values, sometimes at other times too
+        if ((i + 1U) % kHop == 0U || rand() % 7 == 0) {
+            ASSERT_TRUE(hop._check_integrity());
+            ASSERT_EQ(expected.Value(), hop.Value());
+            ASSERT_TRUE(hop._check_integrity());
+        }
+        if ((i + 1U) % kHop == 0U)
+            medians.push_back(expected.Value());
+    }
+    ASSERT_EQ(expected.Size(), hop.Size());
+
+    // batches of various lengths give the same medians
+    std::vector<T> out(data.size() / kHop + 1U);
+    size_t written = 0;
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(data.size() - i, (size_t)(rand() % 50));
+        written += batch.AddBatch(data.data() + i, count, out.data() + written);
+        i += count;
+    }
+    out.resize(written);
+    ASSERT_EQ(medians, out);
+
+    hop.Clear();
+    ASSERT_TRUE(hop.IsEmpty());
+    ASSERT_EQ(T{}, hop.Value());
+}
+
+TEST(RunMedianHopTests, SameAsRunmedian) {
+    CheckHop<uint16_t, 64, 10>(3001U);
+    CheckHop<uint16_t, 64, 1>(3001U);
+    CheckHop<float, 255, 100>(3001U);
+    CheckHop<int32_t, 19, 10>(51U);
+    CheckHop<int32_t, 19, 100>(51U);
+    CheckHop<uint8_t, 5, 3>(256U);
+    CheckHop<double, 1, 4>(3001U);
+    CheckHop<uint16_t, 255, 7>(4U);
+
+    // sequence numbers of values wrap around
+    common::Runmedian<uint16_t, 255> expected{};
+    common::RunmedianHop<uint16_t, 255, 32> hop{};
+    for (uint32_t i = 0; i < 70000U; i++) {
+        const uint16_t val = RANDOM3000();
+        expected.Add(val);
+        hop.Add(val);
+        if (i % 32U == 0U || i > 65500U) {
+            ASSERT_EQ(expected.Value(), hop.Value());
+        }
+    }
+    ASSERT_TRUE(hop._check_integrity());
+}
+
+template <typename T, uint8_t kSize> void CheckHampel(int range, double k_sigma) {
+    common::Hampel<T, kSize> single{};
+    common::Hampel<T, kSize> batch{};
+    single.RegisterCallbacks(HandleError);
+    batch.RegisterCallbacks(HandleError);
+
+    // a noisy signal with spikes of both signs
+    std::vector<T> data(2000);
+    for (size_t i = 0; i < data.size(); i++) {
+        int val = range / 2 + rand() % 21 - 10;
+        if (rand() % 20 == 0)
+            val = rand() % 2 ? range - 1 : 0;
+        data[i] = (T)val;
+    }
+
+    std::vector<T> stream;
+    std::vector<T> expected_out;
+    std::vector<bool> expected_outliers;
+    for (const T val : data) {
+        stream.push_back(val);
+        const size_t count = std::min(stream.size(), (size_t)kSize);
+        const auto median_mad = SortedMedianMad(std::vector<T>(stream.end() - count, stream.end()));
+        const double deviation = std::abs((double)val - (double)median_mad.first);
+        const bool outlier = deviation > k_sigma * 1.4826 * (double)median_mad.second;
+
+        bool is_outlier = !outlier;
+        ASSERT_EQ(outlier ? median_mad.first : val, single.Filter(val, k_sigma, &is_outlier));
+        ASSERT_EQ(outlier, is_outlier);
+        ASSERT_EQ(median_mad.second, single.Mad());
+        expected_out.push_back(outlier ? median_mad.first : val);
+        expected_outliers.push_back(outlier);
+    }
+    ASSERT_TRUE(single._check_integrity());
+
+    // batches of various lengths, filtered in place
+    std::vector<T> out(data);
+    std::unique_ptr<bool[]> outliers(new bool[data.size()]);
+    size_t found = 0;
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(data.size() - i, (size_t)(rand() % 50));
+        found += batch.Filter(out.data() + i, out.data() + i, count, k_sigma, outliers.get() + i);
+        i += count;
+    }
+    ASSERT_EQ(expected_out, out);
+    ASSERT_EQ(expected_outliers, std::vector<bool>(outliers.get(), outliers.get() + data.size()));
+    ASSERT_EQ((size_t)std::count(expected_outliers.begin(), expected_outliers.end(), true), found);
+    ASSERT_GT(found, 0U);
+
+    batch.Clear();
+    ASSERT_TRUE(batch.IsEmpty());
+    ASSERT_EQ(T{}, batch.Value());
+}
+
+TEST(HampelTests, SameAsSort) {
+    CheckHampel<uint16_t, 7>(3001, 3.0);
+    CheckHampel<uint16_t, 64>(3001, 3.0);
+    CheckHampel<int32_t, 19>(1000, 2.0);
+    CheckHampel<float, 33>(3001, 3.0);
+    CheckHampel<uint8_t, 255>(256, 3.0);
+}
+
+#ifdef RUNMEDIAN_RANGES
+TEST(RunMedianViewTests, SameAsLoop) {
+    std::vector<uint16_t> data(1000);
+    for (auto& val : data)
+        val = RANDOM3000();
+
+    // the loop, which the view replaces
+    common::Runmedian<uint16_t, 19> q{};
+    q.RegisterCallbacks(HandleError);
+    std::vector<uint16_t> expected;
+    for (const uint16_t val : data) {
+        q.Add(val);
+        expected.push_back(q.Value());
+    }
+
+    std::vector<uint16_t> medians;
+    auto view = data | common::views::running_median<19>;
+    for (const uint16_t median : view)
+        medians.push_back(median);
+    ASSERT_EQ(expected, medians);
+
+    // begin() starts again from the empty window
+    medians.clear();
+    std::ranges::copy(view, std::back_inserter(medians));
+    ASSERT_EQ(expected, medians);
+
+    // fused with other adaptors, the engine has the value type of its input
+    auto doubled = data | std::views::transform([](uint16_t val) { return (uint32_t)val * 2U + 1U; }) |
+                   common::views::running_median<19> | std::views::take(100);
+    common::Runmedian<uint32_t, 19> q32{};
+    q32.RegisterCallbacks(HandleError);
+    size_t i = 0;
+    for (const uint32_t median : doubled) {
+        q32.Add((uint32_t)data[i] * 2U + 1U);
+        ASSERT_EQ(q32.Value(), median);
+        i++;
+    }
+    ASSERT_EQ(100U, i);
+
+    // a range of the other kind, an empty one
+    std::deque<float> floats{1.0F, 4.0F, 2.0F};
+    std::vector<float> float_medians;
+    std::ranges::copy(common::views::running_median<2>(floats), std::back_inserter(float_medians));
+    ASSERT_EQ((std::vector<float>{1.0F, 2.5F, 3.0F}), float_medians);
+    std::vector<int32_t> empty;
+    auto empty_view = empty | common::views::running_median<5>;
+    ASSERT_TRUE(empty_view.begin() == empty_view.end());
+}
+#ifdef RUNMEDIAN_COROUTINES
+// bump allocator of a fixed buffer, it counts live blocks to check that the frame is released
+struct TestArena {
+    alignas(std::max_align_t) unsigned char buffer[8192];
+    size_t used = 0;
+    size_t live = 0;
+};
+
+template <typename T> struct TestArenaAllocator {
+    using value_type = T;
+
+    explicit TestArenaAllocator(TestArena* arena) : arena(arena) {}
+    template <typename U> TestArenaAllocator(const TestArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        const size_t size = (count * sizeof(T) + alignof(std::max_align_t) - 1U) / alignof(std::max_align_t) *
+                            alignof(std::max_align_t);
+        if (arena->used + size > sizeof(arena->buffer))
+            return nullptr;
+        T* ptr = reinterpret_cast<T*>(arena->buffer + arena->used);
+        arena->used += size;
+        arena->live++;
+        return ptr;
+    }
+    void deallocate(T*, size_t) { arena->live--; }
+
+    TestArena* arena;
+};
+
+TEST(RunMedianViewTests, GeneratorSameAsLoop) {
+    std::vector<uint16_t> data(1000);
+    for (auto& val : data)
+        val = RANDOM3000();
+
+    common::Runmedian<uint16_t, 19> q{};
+    q.RegisterCallbacks(HandleError);
+    std::vector<uint16_t> expected;
+    for (const uint16_t val : data) {
+        q.Add(val);
+        expected.push_back(q.Value());
+    }
+
+    // the frame with the engine is in the arena
+    TestArena arena;
+    {
+        std::vector<uint16_t> medians;
+        for (const uint16_t median :
+             common::RunningMedians<19>(std::allocator_arg, TestArenaAllocator<char>(&arena), data))
+            medians.push_back(median);
+        ASSERT_EQ(expected, medians);
+        ASSERT_LT(sizeof(common::Runmedian<uint16_t, 19>), arena.used);
+    }
+    ASSERT_EQ(0U, arena.live);
+
+    // async source: a callable, which returns the next value until std::nullopt
+    arena.used = 0;
+    {
+        size_t next = 0;
+        auto poll = [&]() -> std::optional<uint16_t> {
+            return next < data.size() ? std::optional<uint16_t>(data[next++]) : std::nullopt;
+        };
+        auto generator = common::RunningMedians<19>(std::allocator_arg, TestArenaAllocator<int>(&arena), poll);
+        std::vector<uint16_t> medians;
+        std::ranges::copy(generator, std::back_inserter(medians));
+        ASSERT_EQ(expected, medians);
+        ASSERT_EQ(data.size(), next);
+    }
+    ASSERT_EQ(0U, arena.live);
+
+    // a generator, which is not run to the end, releases its frame as well, any allocator works
+    {
+        auto generator = common::RunningMedians<2>(std::allocator_arg, std::allocator<float>(),
+                                                   std::vector<float>{1.0F, 4.0F, 2.0F});
+        auto moved = std::move(generator);
+        auto it = moved.begin();
+        ASSERT_EQ(1.0F, *it);
+        ++it;
+        ASSERT_EQ(2.5F, *it);
+    }
+    std::vector<int32_t> empty;
+    auto empty_medians = common::RunningMedians<5>(std::allocator_arg, TestArenaAllocator<char>(&arena), empty);
+    ASSERT_TRUE(empty_medians.begin() == empty_medians.end());
+}
+#endif // RUNMEDIAN_COROUTINES
+#endif // RUNMEDIAN_RANGES
+
+template <typename T, uint8_t kSize> void CheckExtremes(const std::vector<T>& data) {
+    common::RunExtremes<T, kSize> extremes{};
+    common::RunExtremes<T, kSize> batch{};
+    extremes.RegisterCallbacks(HandleError);
+    batch.RegisterCallbacks(HandleError);
+    ASSERT_EQ(T{}, extremes.Max());
+
+    std::vector<T> expected_min;
+    std::vector<T> expected_max;
+    for (size_t i = 0; i < data.size(); i++) {
+        extremes.Add(data[i]);
+        ASSERT_TRUE(extremes._check_integrity());
+
+        const size_t count = std::min(i + 1U, (size_t)kSize);
+        const auto window = std::minmax_element(data.begin() + (i + 1U - count), data.begin() + i + 1U);
+        ASSERT_EQ(count, extremes.Size());
+        ASSERT_EQ(*window.first, extremes.Min());
+        ASSERT_EQ(*window.second, extremes.Max());
+        ASSERT_EQ((T)(*window.second - *window.first), extremes.Range());
+        expected_min.push_back(*window.first);
+        expected_max.push_back(*window.second);
+    }
+
+    // batches of various lengths, with one or both outputs
+    std::vector<T> min_out(data.size());
+    std::vector<T> max_out(data.size());
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(data.size() - i, (size_t)(rand() % 50));
+        batch.AddBatch(data.data() + i, count, min_out.data() + i, i % 2 ? max_out.data() + i : nullptr);
+        if (i % 2 == 0) {
+            std::copy(expected_max.begin() + i, expected_max.begin() + i + count, max_out.begin() + i);
+        }
+        i += count;
+    }
+    ASSERT_TRUE(batch._check_integrity());
+    ASSERT_EQ(expected_min, min_out);
+    ASSERT_EQ(expected_max, max_out);
+
+    extremes.Clear();
+    ASSERT_TRUE(extremes.IsEmpty());
+    ASSERT_EQ(T{}, extremes.Min());
+}
+
+template <typename T, uint8_t kSize> void CheckExtremes(int range) {
+    // random values, duplicates, rising and falling runs, which fill a deque up
+    std::vector<T> data(3000);
+    for (size_t i = 0; i < data.size(); i++) {
+        switch ((i / 500U) % 3U) {
+        case 0:
+            data[i] = (T)(rand() % range);
+            break;
+        case 1:
+            data[i] = (T)(i % range);
+            break;
+        default:
+            data[i] = (T)(range - 1 - (int)(i % range));
+            break;
+        }
+    }
+    CheckExtremes<T, kSize>(data);
+}
+
+TEST(RunExtremesTests, SameAsMinMax) {
+    CheckExtremes<uint16_t, 1>(3001);
+    CheckExtremes<uint16_t, 2>(3);
+    CheckExtremes<uint16_t, 19>(3001);
+    CheckExtremes<int32_t, 64>(51);
+    CheckExtremes<float, 33>(3001);
+    CheckExtremes<uint8_t, 255>(256);
+    CheckExtremes<double, 255>(4);
+}
+
+TEST(RunMedianBankTests, ScatterSameAsRunmedian) {
+    constexpr uint32_t kChannels = 100;
+    auto bank = std::make_unique<common::RunmedianBank<uint16_t, 7, kChannels>>();
+    std::vector<common::Runmedian<uint16_t, 7>> single(kChannels);
+    bank->RegisterCallbacks(HandleError);
+
+    std::vector<uint32_t> channels;
+    std::vector<uint16_t> values;
+    for (int batch = 0; batch < 300; batch++) {
+        channels.clear();
+        values.clear();
+        const int count = rand() % 80;
+        for (int i = 0; i < count; i++) {
+            // some batches hit few channels to have a lot of repeats
+            channels.push_back((uint32_t)(rand() % ((batch % 3) ? kChannels : 5U)));
+            values.push_back(RANDOM50());
+            single[channels.back()].Add(values.back());
+        }
+        bank->Add(channels.data(), values.data(), channels.size());
+        ASSERT_TRUE(bank->_check_integrity());
+        for (uint32_t c = 0; c < kChannels; c++) {
+            ASSERT_EQ(single[c].Size(), bank->Size(c));
+            ASSERT_EQ(single[c].Value(), bank->Value(c));
+        }
+    }
+
+    bank->Add(3, 7);
+    single[3].Add(7);
+    ASSERT_EQ(single[3].Value(), bank->Value(3));
+
+    bank->Clear();
+    ASSERT_TRUE(bank->_check_integrity());
+    ASSERT_EQ(0U, bank->Size(3));
+    ASSERT_EQ(0U, bank->Value(3));
+}
+
+TEST(RunMedianBankTests, DenseSameAsRunmedian) {
+    // the count of channels is not a multiple of vector lanes
+    constexpr uint32_t kChannels = 37;
+    auto bank = std::make_unique<common::RunmedianBank<float, 8, kChannels>>();
+    std::vector<common::Runmedian<float, 8>> single(kChannels);
+    bank->RegisterCallbacks(HandleError);
+
+    float values[kChannels];
+    float medians[kChannels];
+    for (int i = 0; i < 500; i++) {
+        for (uint32_t c = 0; c < kChannels; c++) {
+            values[c] = (float)RANDOM3000() / 7.0f;
+            single[c].Add(values[c]);
+        }
+        bank->AddAll(values);
+        ASSERT_TRUE(bank->_check_integrity());
+        bank->Values(medians);
+        for (uint32_t c = 0; c < kChannels; c++) {
+            ASSERT_EQ(single[c].Value(), medians[c]);
+        }
+    }
+}
+
+TEST(RunMedianBankTests, Infinities) {
+    constexpr uint32_t kChannels = 4;
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    const float kChoice[] = {-kInf, kInf, -1.5f, 0.0f, 2.5f};
+    auto bank = std::make_unique<common::RunmedianBank<float, 3, kChannels, common::NoLock, common::IgnoreError>>();
+    auto scatter = std::make_unique<common::RunmedianBank<float, 3, kChannels, common::NoLock, common::IgnoreError>>();
+    std::vector<common::Runmedian<float, 3, common::NoLock, common::IgnoreError>> single(kChannels);
+
+    float values[kChannels];
+    for (int i = 0; i < 3; i++) {
+        values[0] = -kInf;
+        values[1] = kInf;
+        values[2] = -kInf;
+        values[3] = kInf;
+        bank->AddAll(values);
+        scatter->Add(0, -kInf);
+        scatter->Add(1, kInf);
+    }
+    ASSERT_EQ(-kInf, bank->Value(0));
+    ASSERT_EQ(kInf, bank->Value(1));
+    ASSERT_EQ(-kInf, scatter->Value(0));
+    ASSERT_EQ(kInf, scatter->Value(1));
+
+    bank->Clear();
+    scatter->Clear();
+    for (int i = 0; i < 300; i++) {
+        for (uint32_t c = 0; c < kChannels; c++) {
+            values[c] = kChoice[rand() % 5];
+            single[c].Add(values[c]);
+            scatter->Add(c, values[c]);
+        }
+        bank->AddAll(values);
+        ASSERT_TRUE(bank->_check_integrity());
+        ASSERT_TRUE(scatter->_check_integrity());
+        // two values of a window, which is not full, may be -inf and inf, their midpoint is NaN
+        for (uint32_t c = 0; c < kChannels; c++) {
+            const float expected = single[c].Value();
+            if (std::isnan(expected)) {
+                ASSERT_TRUE(std::isnan(bank->Value(c)));
+                ASSERT_TRUE(std::isnan(scatter->Value(c)));
+            } else {
+                ASSERT_EQ(expected, bank->Value(c));
+                ASSERT_EQ(expected, scatter->Value(c));
+            }
+        }
+    }
+}
+
+template <uint32_t kSize> void CheckRqueue() {
+    common::Rqueue<uint32_t, kSize, common::NoLock> queue{};
+    std::deque<uint32_t> expected;
+    std::vector<uint32_t> block(kSize + 10U);
+    uint32_t next = 0;
+
+    for (uint32_t step = 0; step < 20000; step++) {
+        const uint32_t count = (uint32_t)rand() % (kSize + 10U);
+        switch (rand() % 6) {
+        case 0: {
+            for (uint32_t i = 0; i < count; i++)
+                block[i] = next++;
+            const uint32_t pushed = queue.PushN(block.data(), count);
+            ASSERT_EQ(std::min<size_t>(count, kSize - expected.size()), pushed);
+            expected.insert(expected.end(), block.begin(), block.begin() + pushed);
+            break;
+        }
+        case 1: {
+            const uint32_t popped = queue.PopN(block.data(), count);
+            ASSERT_EQ(std::min<size_t>(count, expected.size()), popped);
+            ASSERT_TRUE(std::equal(block.begin(), block.begin() + popped, expected.begin()));
+            expected.erase(expected.begin(), expected.begin() + popped);
+            break;
+        }
+        case 2:
+            // the oldest one is replaced, if the queue is full
+            queue.Add(next);
+            expected.push_back(next++);
+            if (expected.size() > kSize)
+                expected.pop_front();
+            break;
+        case 3:
+            ASSERT_EQ(expected.size() < kSize, queue.TryAdd(next));
+            if (expected.size() < kSize)
+                expected.push_back(next);
+            next++;
+            break;
+        case 4:
+            queue.DeleteHead(count);
+            expected.erase(expected.begin(), expected.begin() + std::min<size_t>(count, expected.size()));
+            break;
+        default:
+            if (!expected.empty()) {
+                queue.DeleteTail();
+                expected.pop_back();
+            }
+            break;
+        }
+
+        ASSERT_EQ(expected.size(), queue.Size());
+        const auto spans = queue.Spans();
+        ASSERT_EQ(expected.size(), spans.first.size + spans.second.size);
+        ASSERT_TRUE(std::equal(spans.first.data, spans.first.data + spans.first.size, expected.begin()));
+        ASSERT_TRUE(std::equal(spans.second.data, spans.second.data + spans.second.size,
+                               expected.begin() + spans.first.size));
+        if (!expected.empty()) {
+            ASSERT_EQ(expected.front(), queue.Head());
+            ASSERT_EQ(expected.back(), queue.Tail());
+            const uint32_t index = (uint32_t)rand() % expected.size();
+            ASSERT_EQ(expected[index], queue[index]);
+        }
+    }
+
+    queue.DeleteAll();
+    ASSERT_EQ(0U, queue.Size());
+    ASSERT_EQ(0U, queue.Spans().first.size + queue.Spans().second.size);
+}
+
+TEST(RqueueTests, BulkSameAsDeque) {
+    CheckRqueue<1>();
+    CheckRqueue<7>();
+    CheckRqueue<16>();
+    CheckRqueue<255>();
+    CheckRqueue<256>();
+    CheckRqueue<1000>();
+    static_assert(sizeof(common::Rqueue<uint8_t, 255, common::NoLock>) == 257U, "size type is uint8_t");
+    static_assert(std::is_same<common::Rqueue<uint8_t, 1000>::SizeType, uint16_t>::value, "size type is uint16_t");
+}
+
+TEST(RunMedianSpscTests, ProducerConsumerReader) {
+    constexpr int32_t kCount = 200000;
+    common::RunmedianSpsc<int32_t, 5, 64> q{};
+    std::atomic<bool> done{false};
+
+    std::thread producer([&q]() {
+        for (int32_t i = 0; i < kCount; i++) {
+            while (!q.Push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::thread reader([&q, &done]() {
+        int32_t last = 0;
+        while (!done.load()) {
+            // growing values give growing medians, a torn snapshot would break it
+            const common::RunmedianSnapshot<int32_t> snapshot = q.Snapshot();
+            ASSERT_LE(snapshot.size, 5U);
+            ASSERT_GE(snapshot.median, last);
+            ASSERT_TRUE(snapshot.size == 5U || snapshot.median < 2);
+            last = snapshot.median;
+            std::this_thread::yield();
+        }
+    });
+
+    int32_t median = 0;
+    do {
+        if (q.Pending() == 0U) {
+            // let the producer run on a machine with a few cores
+            std::this_thread::yield();
+        }
+        median = q.Update();
+    } while (median != kCount - 3);
+
+    producer.join();
+    done.store(true);
+    reader.join();
+
+    ASSERT_EQ(0U, q.Pending());
+    ASSERT_EQ(kCount - 3, q.Value());
+    ASSERT_EQ(5U, q.Snapshot().size);
+
+    q.Clear();
+    ASSERT_EQ(0, q.Value());
+    ASSERT_EQ(0U, q.Snapshot().size);
+}
+
+TEST(RunMedianRegistryTests, SameAsMap) {
+    constexpr uint32_t kCapacity = 32;
+    constexpr uint32_t kTtl = 50;
+    using Registry =
+        common::RunmedianRegistry<uint16_t, 7, kCapacity, int32_t, uint32_t, common::NoLock, common::IgnoreError>;
+    auto registry = std::make_unique<Registry>(kTtl);
+
+    // channels with time and order of the last Add(), the least recently used one is reclaimed first
+    struct Channel {
+        common::Runmedian<uint16_t, 7, common::NoLock, common::IgnoreError> engine;
+        uint32_t last;
+        uint64_t used;
+    };
+    std::map<int32_t, Channel> channels;
+    uint32_t now = 0xFFFFFF00U; // the clock wraps around during the test
+    uint64_t used = 0;
+
+    for (uint32_t step = 0; step < 30000; step++) {
+        now += (uint32_t)(rand() % 3);
+        const int32_t key = rand() % 64 - 20;
+        const int op = rand() % 100;
+        if (op < 85) {
+            auto it = channels.find(key);
+            if (it == channels.end() && channels.size() == kCapacity) {
+                auto lru = std::min_element(channels.begin(), channels.end(), [](const auto& a, const auto& b) {
+                    return a.second.used < b.second.used;
+                });
+                if (now - lru->second.last >= kTtl) {
+                    channels.erase(lru);
+                }
+            }
+            if (it == channels.end() && channels.size() < kCapacity) {
+                it = channels.emplace(key, Channel{}).first;
+            }
+            if (it != channels.end()) {
+                const uint16_t val = RANDOM3000();
+                it->second.engine.Add(val);
+                it->second.last = now;
+                it->second.used = used++;
+                registry->Add(key, val, now);
+            } else {
+                registry->Add(key, 1, now);
+                ASSERT_FALSE(registry->Contains(key));
+            }
+        } else if (op < 92) {
+            ASSERT_EQ(channels.erase(key) == 1U, registry->Remove(key));
+        } else if (op < 99) {
+            uint32_t expired = 0;
+            for (auto it = channels.begin(); it != channels.end();) {
+                if (now - it->second.last >= kTtl) {
+                    it = channels.erase(it);
+                    expired++;
+                } else {
+                    ++it;
+                }
+            }
+            ASSERT_EQ(expired, registry->Expire(now));
+        } else if (step % 10 == 0) {
+            channels.clear();
+            registry->Clear();
+        }
+
+        ASSERT_EQ(channels.size(), registry->Count());
+        const auto it = channels.find(key);
+        ASSERT_EQ(it != channels.end(), registry->Contains(key));
+        ASSERT_EQ(it != channels.end() ? it->second.engine.Value() : 0U, registry->Value(key));
+        ASSERT_EQ(it != channels.end() ? it->second.engine.Size() : 0U, registry->Size(key));
+        if (step % 97 == 0) {
+            ASSERT_TRUE(registry->_check_integrity());
+        }
+    }
+    ASSERT_TRUE(registry->_check_integrity());
+
+    // an earlier timestamp is the latest one, so the channel is not idle longer
+    registry->Clear();
+    registry->Add(1, 10, 1000);
+    registry->Add(2, 20, 900);
+    ASSERT_EQ(0U, registry->Expire(1000 + kTtl - 1U));
+    ASSERT_EQ(2U, registry->Expire(1000 + kTtl));
+    ASSERT_TRUE(registry->_check_integrity());
+}
+
+TEST(RunMedianRegistryTests, ShardedThreads) {
+    constexpr int kThreads = 4;
+    constexpr uint32_t kKeys = 50;
+    auto registry = std::make_unique<common::RunmedianRegistrySharded<uint16_t, 9, 64, 8>>(1000U);
+
+    // every thread has its own keys and clock, shards are shared
+    std::vector<std::thread> threads;
+    std::vector<std::vector<common::Runmedian<uint16_t, 9, common::NoLock, common::IgnoreError>>> expected(kThreads);
+    for (int t = 0; t < kThreads; t++) {
+        expected[t].resize(kKeys);
+        threads.emplace_back([&registry, &expected, t]() {
+            uint32_t seed = (uint32_t)t + 1U;
+            for (uint32_t i = 0; i < 100000; i++) {
+                seed = seed * 1664525U + 1013904223U;
+                const uint32_t key = (seed >> 8) % kKeys;
+                const uint16_t val = (uint16_t)(seed >> 16);
+                expected[t][key].Add(val);
+                registry->Add(key * kThreads + (uint32_t)t, val, i / 100U);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_TRUE(registry->_check_integrity());
+    ASSERT_EQ(kThreads * kKeys, registry->Count());
+    for (int t = 0; t < kThreads; t++) {
+        for (uint32_t key = 0; key < kKeys; key++) {
+            ASSERT_EQ(expected[t][key].Value(), registry->Value(key * kThreads + (uint32_t)t));
+        }
+    }
+
+    ASSERT_EQ(kThreads * kKeys, registry->Expire(5000U));
+    ASSERT_EQ(0U, registry->Count());
+}
+
+TEST(MedFilterTests, SameAsSequential) {
+    std::vector<uint16_t> data(300000);
+    for (auto& val : data)
+        val = RANDOM3000();
+
+    common::Runmedian<uint16_t, 19> q{};
+    std::vector<uint16_t> expected(data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        q.Add(data[i]);
+        expected[i] = q.Value();
+    }
+
+    for (uint32_t threads : {1U, 3U, 4U, 64U}) {
+        std::vector<uint16_t> out(data.size());
+        ASSERT_TRUE((common::RunningMedian<uint16_t, 19>(data.data(), data.size(), out.data(), threads)));
+        ASSERT_EQ(expected, out);
+    }
+
+    // shorter than the window
+    std::vector<uint16_t> out(10);
+    ASSERT_TRUE((common::RunningMedian<uint16_t, 19>(data.data(), out.size(), out.data())));
+    ASSERT_TRUE(std::equal(out.begin(), out.end(), expected.begin()));
+
+    ASSERT_TRUE((common::RunningMedian<uint16_t, 19>(nullptr, 0, nullptr)));
+    ASSERT_FALSE((common::RunningMedian<uint16_t, 19>(nullptr, 10, out.data())));
+}
+
+TEST(MedFilterTests, LargeSameAsSequential) {
+    std::vector<float> data(400000);
+    for (auto& val : data)
+        val = (float)RANDOM3000() / 7.0f;
+
+    auto q = std::make_unique<common::RunmedianLarge<float, 1000>>();
+    std::vector<float> expected(data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        q->Add(data[i]);
+        expected[i] = q->Value();
+    }
+
+    std::vector<float> out(data.size());
+    ASSERT_TRUE((common::RunningMedianLarge<float, 1000>(data.data(), data.size(), out.data(), 8)));
+    ASSERT_EQ(0, memcmp(expected.data(), out.data(), out.size() * sizeof(float)));
+}
+
+// brute force median of the square kernel, pixels out of the frame are taken by the border mode
+template <typename TPixel>
+std::vector<TPixel> Median2DWithSort(const std::vector<TPixel>& in, int width, int height, int radius,
+                                     common::MedianBorder border, TPixel constant) {
+    auto index = [border](int pos, int size) {
+        if (pos >= 0 && pos < size)
+            return pos;
+        if (border == common::MedianBorder::kConstant)
+            return -1;
+        if (border == common::MedianBorder::kReplicate || size == 1)
+            return pos < 0 ? 0 : size - 1;
+        while (pos < 0 || pos >= size)
+            pos = pos < 0 ? -pos : 2 * (size - 1) - pos;
+        return pos;
+    };
+
+    std::vector<TPixel> out(in.size());
+    std::vector<TPixel> kernel;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            kernel.clear();
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    const int sy = index(y + dy, height);
+                    const int sx = index(x + dx, width);
+                    kernel.push_back((sy < 0 || sx < 0) ? constant : in[(size_t)sy * width + sx]);
+                }
+            }
+            std::nth_element(kernel.begin(), kernel.begin() + kernel.size() / 2, kernel.end());
+            out[(size_t)y * width + x] = kernel[kernel.size() / 2];
+        }
+    }
+    return out;
+}
+
+template <typename TPixel, uint32_t kBits> void CheckMedian2D(int width, int height, uint32_t range) {
+    std::vector<TPixel> in((size_t)width * height);
+    for (auto& val : in)
+        val = (TPixel)(rand() % range);
+
+    for (int radius : {0, 1, 2, 5, 20}) {
+        for (auto border : {common::MedianBorder::kReplicate, common::MedianBorder::kReflect,
+                            common::MedianBorder::kConstant}) {
+            const TPixel constant = (TPixel)(range / 3U);
+            const std::vector<TPixel> expected = Median2DWithSort(in, width, height, radius, border, constant);
+            for (uint32_t threads : {1U, 4U}) {
+                std::vector<TPixel> out(in.size());
+                ASSERT_TRUE((common::MedianFilter2D<TPixel, kBits>(in.data(), out.data(), width, height, radius,
+                                                                   border, constant, threads)));
+                ASSERT_EQ(expected, out) << "radius " << radius << " border " << (int)border;
+            }
+        }
+    }
+}
+
+TEST(MedFilterTests, Median2DSameAsSort) {
+    CheckMedian2D<uint8_t, 8>(37, 150, 256);
+    CheckMedian2D<uint8_t, 8>(1, 3, 256);
+    CheckMedian2D<uint16_t, 12>(300, 140, 4096);
+    CheckMedian2D<uint16_t, 10>(45, 23, 1024);
+
+    // wider than a tile of 12 bits histograms
+    CheckMedian2D<uint16_t, 12>(700, 9, 50);
+
+    std::vector<uint16_t> in(64 * 64, 100);
+    std::vector<uint16_t> out(in.size());
+    in[5] = 4096;
+    ASSERT_FALSE((common::MedianFilter2D<uint16_t>(in.data(), out.data(), 64, 64, 1)));
+    ASSERT_EQ(100, out[5]);
+    ASSERT_FALSE((common::MedianFilter2D<uint16_t>(in.data(), out.data(), 64, 64, 128)));
+    ASSERT_FALSE((common::MedianFilter2D<uint16_t>(nullptr, out.data(), 64, 64, 1)));
+    ASSERT_TRUE((common::MedianFilter2D<uint16_t>(nullptr, nullptr, 0, 0, 1)));
+}
+
+// sink of decoded values, it stops after limit values
+template <typename T> struct TraceSink {
+    bool Push(const T* data, size_t count) {
+        values.insert(values.end(), data, data + count);
+        return values.size() < limit;
+    }
+
+    std::vector<T> values;
+    size_t limit = SIZE_MAX;
+};
+
+TEST(RunMedianTraceTests, ParseField) {
+    auto parse = [](const char* text, int32_t& val) {
+        return common::ParseTraceField(text, text + std::strlen(text), val);
+    };
+    int32_t val = 0;
+    ASSERT_TRUE(parse("12", val));
+    ASSERT_EQ(12, val);
+    ASSERT_TRUE(parse("  +7 \r", val));
+    ASSERT_EQ(7, val);
+    ASSERT_TRUE(parse("-3;4", val));
+    ASSERT_EQ(-3, val);
+    ASSERT_TRUE(parse("5 ,x", val));
+    ASSERT_EQ(5, val);
+
+    // the whole field must be a number of the type
+    for (const char* text : {"1.9", "2.5", "1e3", "12a", "", " ", "+", "++1", "1 2", "value", "99999999999"}) {
+        ASSERT_FALSE(parse(text, val)) << text;
+    }
+
+    int16_t small = 0;
+    const char* big = "40000";
+    ASSERT_FALSE(common::ParseTraceField(big, big + 5, small));
+    double real = 0.0;
+    const char* exp = "1e3\r";
+    ASSERT_TRUE(common::ParseTraceField(exp, exp + 4, real));
+    ASSERT_EQ(1000.0, real);
+}
+
+TEST(RunMedianTraceTests, DecodeText) {
+    const std::string text = "time;value\n0;1.9\n1; 2 \r\n\r\n2;+3\n3\n4;1e3\n5\t7\n6;-8";
+    common::TraceStats stats;
+    TraceSink<int32_t> sink;
+    bool ok = true;
+
+    // without the last block the line without a new line stays for the next block
+    size_t used = common::DecodeTextTrace<int32_t>(text.data(), text.size(), false, 1U, sink, stats, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(text.rfind('\n') + 1U, used);
+    ASSERT_EQ((std::vector<int32_t>{2, 3, 7}), sink.values);
+    // header, 1.9, a line without the column and 1e3
+    ASSERT_EQ(4U, stats.skipped);
+
+    used += common::DecodeTextTrace<int32_t>(text.data() + used, text.size() - used, true, 1U, sink, stats, ok);
+    ASSERT_EQ(text.size(), used);
+    ASSERT_EQ((std::vector<int32_t>{2, 3, 7, -8}), sink.values);
+
+    // the first column
+    TraceSink<float> floats;
+    const std::string lines = "1.5,a\n2.5\n";
+    used = common::DecodeTextTrace<float>(lines.data(), lines.size(), true, 0U, floats, stats, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ((std::vector<float>{1.5F, 2.5F}), floats.values);
+    ASSERT_EQ(lines.size(), used);
+    // the sink stops decoding
+    floats.limit = 1U;
+    std::string many;
+    for (size_t i = 0; i < common::kTraceBatch + 10U; i++)
+        many += std::to_string(i) + "\n";
+    floats.values.clear();
+    used = common::DecodeTextTrace<float>(many.data(), many.size(), true, 0U, floats, stats, ok);
+    ASSERT_FALSE(ok);
+    ASSERT_EQ(common::kTraceBatch, floats.values.size());
+}
+
+TEST(RunMedianTraceTests, DecodeBinary) {
+    // records of 3 little-endian int16 values, the last record is not complete
+    std::vector<unsigned char> data;
+    for (int16_t i = 0; i < 10; i++) {
+        for (int16_t column = 0; column < 3; column++) {
+            const int16_t val = (int16_t)(i * 1000 - column - 300);
+            data.push_back((unsigned char)((uint16_t)val & 0xFFU));
+            data.push_back((unsigned char)((uint16_t)val >> 8));
+        }
+    }
+    data.push_back(1U);
+
+    TraceSink<int16_t> sink;
+    bool ok = true;
+    const size_t used = common::DecodeBinaryTrace<int16_t>(data.data(), data.size(), 2U, 3U, sink, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(data.size() - 1U, used);
+    ASSERT_EQ(10U, sink.values.size());
+    for (size_t i = 0; i < sink.values.size(); i++)
+        ASSERT_EQ((int16_t)(i * 1000U - 302U), sink.values[i]);
+
+    const unsigned char bytes[] = {0x00, 0x00, 0xC0, 0x3F};
+    ASSERT_EQ(1.5F, common::LoadLe<float>(bytes));
+    unsigned char stored[8]{};
+    common::StoreLe(-2.0, stored);
+    ASSERT_EQ(0xC0U, stored[7]);
+    ASSERT_EQ(-2.0, common::LoadLe<double>(stored));
+}
+
+TEST(RunMedianTraceTests, Writer) {
+    for (const bool text : {false, true}) {
+        FILE* file = std::tmpfile();
+        ASSERT_NE(nullptr, file);
+        common::TraceStats stats;
+        std::vector<int32_t> medians(common::kTraceBlock / 2U);
+        for (size_t i = 0; i < medians.size(); i++)
+            medians[i] = (int32_t)i - 1000;
+
+        {
+            common::TraceWriter<int32_t> writer(file, text, stats);
+            ASSERT_TRUE(writer.Put(medians.data(), medians.size()));
+            ASSERT_TRUE(writer.Put(medians.data(), 3U));
+            ASSERT_TRUE(writer.Flush());
+        }
+        ASSERT_EQ(medians.size() + 3U, stats.medians);
+
+        std::string expected;
+        for (size_t i = 0; i < medians.size() + 3U; i++) {
+            const int32_t val = medians[i % medians.size()];
+            if (text) {
+                expected += std::to_string(val) + "\n";
+            } else {
+                unsigned char bytes[4];
+                common::StoreLe(val, bytes);
+                expected.append((const char*)bytes, 4U);
+            }
+        }
+        ASSERT_EQ(expected.size(), stats.bytes_out);
+        std::string written(expected.size() + 1U, '\0');
+        std::rewind(file);
+        written.resize(std::fread(&written[0], 1, written.size(), file));
+        std::fclose(file);
+        ASSERT_EQ(expected, written);
+    }
+
+    // floating point medians are written as the shortest text, which reads back the same
+    FILE* file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    common::TraceStats stats;
+    common::TraceWriter<double> writer(file, true, stats);
+    const double medians[] = {0.1, -2.5, 1e300};
+    ASSERT_TRUE(writer.Put(medians, 3U));
+    ASSERT_TRUE(writer.Flush());
+    std::rewind(file);
+    char written[64]{};
+    ASSERT_EQ(stats.bytes_out, std::fread(written, 1, sizeof(written), file));
+    std::fclose(file);
+    ASSERT_STREQ("0.1\n-2.5\n1e+300\n", written);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    srand((unsigned int)time(NULL));
+    return RUN_ALL_TESTS();
+}
+
+//int main()
+//{
+//    common::Runmedian<int, 8> rm;
+//    rm.Add(1);
+//    std::cout << "Hello World!\n" << rm.Value() << std::endl;
+//}
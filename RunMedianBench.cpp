@@ -0,0 +1,850 @@
+#include "include/medfilter2d.hpp"
+#include "include/remedian.hpp"
+#include "include/rmcheckpoint.hpp"
+#include "include/rqueue.hpp"
+#include "include/runextremes.hpp"
+#include "include/runmedian.hpp"
+#include "include/runmedianbank.hpp"
+#include "include/runmedianhistogram.hpp"
+#include "include/runmedianhop.hpp"
+#include "include/runmedianlarge.hpp"
+#include "include/runmedianregistry.hpp"
+#include "include/runmedianspsc.hpp"
+#include "include/runmediantimed.hpp"
+#include "include/runmedianview.hpp"
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Every benchmark iteration feeds the same kSamples values, so the time of an iteration divided by kSamples
+// is the cost of one Add() + Value() pair. Counters report it as per_sample time and samples/s (items_per_second).
+
+namespace {
+
+constexpr size_t kSamples = 4096;
+
+enum Distribution { kRising, kFalling, kRandom, kDuplicates, kSawtooth };
+
+struct DistributionInfo {
+    Distribution id;
+    const char* name;
+};
+
+constexpr DistributionInfo kDistributions[] = {
+    {kRising, "rising"},         // as Median4TestGrowing
+    {kFalling, "falling"},       // as Median4TestDecreasing
+    {kRandom, "random"},         // as RandomTest
+    {kDuplicates, "duplicates"}, // 4 distinct values only
+    {kSawtooth, "sawtooth"},     // rising with period of 100 values
+};
+
+template <typename T> std::vector<T> MakeSamples(Distribution distribution) {
+    // values fit to uint8_t as well, rising and falling ones repeat a value for narrow types
+    const uint32_t range = sizeof(T) == 1U ? 256U : 3001U;
+    std::mt19937 random(12345U);
+    std::vector<T> samples(kSamples);
+
+    for (size_t i = 0; i < kSamples; i++) {
+        uint32_t val = 0;
+        switch (distribution) {
+        case kRising:
+            val = (uint32_t)(i * range / kSamples);
+            break;
+        case kFalling:
+            val = (uint32_t)((kSamples - 1U - i) * range / kSamples);
+            break;
+        case kRandom:
+            val = random() % range;
+            break;
+        case kDuplicates:
+            val = random() % 4U;
+            break;
+        case kSawtooth:
+            val = (uint32_t)(i % 100U);
+            break;
+        }
+        samples[i] = (T)val;
+    }
+
+    return samples;
+}
+
+void SetCounters(benchmark::State& state) {
+    state.SetItemsProcessed((int64_t)(state.iterations() * kSamples));
+    state.counters["per_sample"] = benchmark::Counter(
+        (double)kSamples, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+/// @brief Baseline: copy of the window and std::nth_element for every value.
+template <typename T, uint8_t kSize> class NthElementMedian {
+  public:
+    void Add(T val) {
+        window_[head_] = val;
+        head_ = (uint8_t)((head_ + 1U == kSize) ? 0U : head_ + 1U);
+        if (count_ < kSize)
+            count_++;
+    }
+
+    T Value() {
+        if (count_ == 0U)
+            return T{};
+
+        std::copy(window_, window_ + count_, work_);
+        const uint8_t half = (uint8_t)(count_ >> 1);
+        std::nth_element(work_, work_ + half, work_ + count_);
+        if (count_ % 2)
+            return work_[half];
+
+        // the lower middle value is the greatest one at the lower half
+        const T lo = *std::max_element(work_, work_ + half);
+        return common::detail::Midpoint(lo, work_[half]);
+    }
+
+  private:
+    T window_[kSize]{};
+    T work_[kSize]{};
+    uint8_t head_{};
+    uint8_t count_{};
+};
+
+/// @brief Baseline of MAD: median of the window by Runmedian, deviations are copied out and sorted for every value.
+template <typename T, uint8_t kSize> class SortMad {
+  public:
+    void Add(T val) {
+        window_.Add(val);
+    }
+
+    T Value() const {
+        return window_.Value();
+    }
+
+    T Mad() {
+        const uint8_t count = window_.Size();
+        const T median = window_.Value();
+        for (uint8_t i = 0; i < count; i++) {
+            const T val = window_.Rank(i);
+            work_[i] = (T)(val < median ? median - val : val - median);
+        }
+        std::sort(work_, work_ + count);
+        const uint8_t half = (uint8_t)(count >> 1);
+        return (count % 2) ? work_[half] : common::detail::Midpoint(work_[half - 1U], work_[half]);
+    }
+
+  private:
+    common::Runmedian<T, kSize, common::NoLock, common::IgnoreError> window_{};
+    T work_[kSize]{};
+};
+
+/// @brief Baseline of extremes: the ends of the sorted array of Runmedian.
+template <typename T, uint8_t kSize> class SortedExtremes {
+  public:
+    void Add(T val) {
+        window_.Add(val);
+    }
+
+    T Min() const {
+        return window_.Rank(0);
+    }
+
+    T Max() const {
+        return window_.Rank((uint8_t)(window_.Size() - 1U));
+    }
+
+  private:
+    common::Runmedian<T, kSize, common::NoLock, common::IgnoreError> window_{};
+};
+
+template <typename TEngine, typename T> void BM_Median(benchmark::State& state, Distribution distribution) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    TEngine engine{};
+
+    for (auto _ : state) {
+        for (const T val : samples) {
+            engine.Add(val);
+            benchmark::DoNotOptimize(engine.Value());
+        }
+    }
+
+    SetCounters(state);
+}
+
+template <typename TEngine, typename T> void BM_Mad(benchmark::State& state, Distribution distribution) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    TEngine engine{};
+
+    for (auto _ : state) {
+        for (const T val : samples) {
+            engine.Add(val);
+            benchmark::DoNotOptimize(engine.Value());
+            benchmark::DoNotOptimize(engine.Mad());
+        }
+    }
+
+    SetCounters(state);
+}
+
+#ifdef RUNMEDIAN_RANGES
+#ifdef RUNMEDIAN_COROUTINES
+/// @brief Allocator of one coroutine frame at a time in a static buffer, the benchmark measures no heap.
+template <typename T> struct FrameAllocator {
+    using value_type = T;
+
+    FrameAllocator() = default;
+    template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        alignas(std::max_align_t) static unsigned char buffer[4096];
+        return count * sizeof(T) <= sizeof(buffer) ? reinterpret_cast<T*>(buffer) : nullptr;
+    }
+    void deallocate(T*, size_t) {}
+};
+#endif // RUNMEDIAN_COROUTINES
+
+enum class Pipeline { kView, kLoop, kGenerator };
+
+/// @brief A pipeline of scaling, running median and sum of medians: the view and the generator against the same
+/// hand written loop.
+template <typename T, uint8_t kSize>
+void BM_View(benchmark::State& state, Distribution distribution, Pipeline pipeline) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    const auto scale = [](T val) { return (T)(val / 2); };
+
+    for (auto _ : state) {
+        double sum = 0.0;
+        if (pipeline == Pipeline::kView) {
+            for (const T median : samples | std::views::transform(scale) | common::views::running_median<kSize>)
+                sum += (double)median;
+        } else if (pipeline == Pipeline::kLoop) {
+            common::Runmedian<T, kSize, common::NoLock, common::IgnoreError> engine{};
+            for (const T val : samples) {
+                engine.Add(scale(val));
+                sum += (double)engine.Value();
+            }
+        } else {
+#ifdef RUNMEDIAN_COROUTINES
+            for (const T median : common::RunningMedians<kSize>(std::allocator_arg, FrameAllocator<T>(),
+                                                                samples | std::views::transform(scale)))
+                sum += (double)median;
+#endif
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    SetCounters(state);
+}
+
+template <typename T, uint8_t kSize> void RegisterView(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("View" + suffix).c_str(), BM_View<T, kSize>, distribution.id, Pipeline::kView);
+        benchmark::RegisterBenchmark(("Loop" + suffix).c_str(), BM_View<T, kSize>, distribution.id, Pipeline::kLoop);
+#ifdef RUNMEDIAN_COROUTINES
+        benchmark::RegisterBenchmark(("Generator" + suffix).c_str(), BM_View<T, kSize>, distribution.id,
+                                     Pipeline::kGenerator);
+#endif
+    }
+}
+#endif // RUNMEDIAN_RANGES
+
+template <typename TEngine, typename T> void BM_Extremes(benchmark::State& state, Distribution distribution) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    TEngine engine{};
+
+    for (auto _ : state) {
+        for (const T val : samples) {
+            engine.Add(val);
+            benchmark::DoNotOptimize(engine.Min());
+            benchmark::DoNotOptimize(engine.Max());
+        }
+    }
+
+    SetCounters(state);
+}
+
+/// @brief Timestamps are sample numbers and the horizon is kSize, so the window is the same as for Runmedian,
+/// every Add() expires one value. Bursts expire kSize / 2 values at once after every kSize / 2 values.
+template <typename T, uint8_t kSize>
+void BM_Timed(benchmark::State& state, Distribution distribution, bool bursts) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    common::RunmedianTimed<T, kSize> engine(kSize);
+    const uint32_t burst = std::max(1U, kSize / 2U);
+    uint32_t now = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            now += bursts ? (i % burst == 0U ? burst : 0U) : 1U;
+            engine.Add(samples[i], now);
+            benchmark::DoNotOptimize(engine.Value(now));
+        }
+    }
+
+    SetCounters(state);
+}
+
+/// @brief Decimation: Add() of every value and Value() of every kHop-th one.
+template <typename TEngine, typename T, uint8_t kHop>
+void BM_Decimate(benchmark::State& state, Distribution distribution) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    TEngine engine{};
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            engine.Add(samples[i]);
+            if (i % kHop == 0U)
+                benchmark::DoNotOptimize(engine.Value());
+        }
+    }
+
+    SetCounters(state);
+}
+
+template <typename T, uint8_t kSize, uint8_t kHop> void RegisterDecimate(const char* type_name) {
+    const std::string args =
+        std::string("<") + type_name + "," + std::to_string(kSize) + ",hop" + std::to_string(kHop) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("RunmedianDecimate" + suffix).c_str(),
+                                     BM_Decimate<common::Runmedian<T, kSize>, T, kHop>, distribution.id);
+        benchmark::RegisterBenchmark(("Hop" + suffix).c_str(),
+                                     BM_Decimate<common::RunmedianHop<T, kSize, kHop>, T, kHop>, distribution.id);
+    }
+}
+
+template <typename T, uint8_t kSize> void BM_Rqueue(benchmark::State& state, Distribution distribution) {
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    common::Rqueue<T, kSize> queue{};
+
+    for (auto _ : state) {
+        for (const T val : samples) {
+            queue.Add(val);
+            benchmark::DoNotOptimize(queue.Head());
+        }
+    }
+
+    SetCounters(state);
+}
+
+/// @brief Rqueue with a mutex as the ingest buffer of Runmedian: blocks of 64 values go in and are drained,
+/// one value per locked call or the whole block by PushN() and Spans() into AddBatch().
+template <typename T, uint8_t kSize> void BM_Ingest(benchmark::State& state, Distribution distribution, bool bulk) {
+    constexpr uint32_t kBlock = 64;
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    common::Rqueue<T, 256, common::StdMutex> queue{};
+    common::Runmedian<T, kSize, common::NoLock, common::IgnoreError> engine{};
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < samples.size(); i += kBlock) {
+            if (bulk) {
+                queue.PushN(samples.data() + i, kBlock);
+                const auto spans = queue.Spans();
+                engine.AddBatch(spans.first.data, spans.first.size);
+                engine.AddBatch(spans.second.data, spans.second.size);
+                queue.DeleteHead(spans.first.size + spans.second.size);
+            } else {
+                for (uint32_t j = 0; j < kBlock; j++) {
+                    queue.TryAdd(samples[i + j]);
+                }
+                while (queue.Size() > 0U) {
+                    engine.Add(queue.Head());
+                    queue.DeleteHead();
+                }
+            }
+            benchmark::DoNotOptimize(engine.Value());
+        }
+    }
+
+    SetCounters(state);
+}
+
+enum BankMode { kBankAll, kBankScatter, kSeparateAll, kSeparateScatter };
+
+/// @brief kChannels channels get kSamples values per iteration: one value to every channel in turn (All)
+/// or to random channels (Scatter), by RunmedianBank or by a separate Runmedian per channel.
+template <typename T, uint8_t kSize, uint32_t kChannels>
+void BM_Bank(benchmark::State& state, Distribution distribution, BankMode mode) {
+    static_assert(kSamples % kChannels == 0U, "whole rounds of channels");
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    std::mt19937 random(777U);
+    std::vector<uint32_t> channels(kSamples);
+    for (size_t i = 0; i < kSamples; i++)
+        channels[i] = (mode == kBankAll || mode == kSeparateAll) ? (uint32_t)(i % kChannels) : random() % kChannels;
+
+    auto bank = std::make_unique<common::RunmedianBank<T, kSize, kChannels, common::NoLock, common::IgnoreError>>();
+    std::vector<common::Runmedian<T, kSize, common::NoLock, common::IgnoreError>> separate(kChannels);
+
+    for (auto _ : state) {
+        switch (mode) {
+        case kBankAll:
+            for (size_t i = 0; i < kSamples; i += kChannels)
+                bank->AddAll(samples.data() + i);
+            break;
+        case kBankScatter:
+            bank->Add(channels.data(), samples.data(), kSamples);
+            break;
+        case kSeparateAll:
+        case kSeparateScatter:
+            for (size_t i = 0; i < kSamples; i++)
+                separate[channels[i]].Add(samples[i]);
+            break;
+        }
+        benchmark::DoNotOptimize(bank->Value(0));
+        benchmark::DoNotOptimize(separate[0].Value());
+    }
+
+    SetCounters(state);
+}
+
+template <typename T, uint8_t kSize, uint32_t kChannels> void RegisterBank(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + "," +
+                             std::to_string(kChannels) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("BankAll" + suffix).c_str(), BM_Bank<T, kSize, kChannels>, distribution.id,
+                                     kBankAll);
+        benchmark::RegisterBenchmark(("SeparateAll" + suffix).c_str(), BM_Bank<T, kSize, kChannels>,
+                                     distribution.id, kSeparateAll);
+        benchmark::RegisterBenchmark(("BankScatter" + suffix).c_str(), BM_Bank<T, kSize, kChannels>,
+                                     distribution.id, kBankScatter);
+        benchmark::RegisterBenchmark(("SeparateScatter" + suffix).c_str(), BM_Bank<T, kSize, kChannels>,
+                                     distribution.id, kSeparateScatter);
+    }
+}
+
+/// @brief One thread adds values while another one polls the median all the time: RunmedianSpsc with Push() of
+/// every value and Update() per block of 64 values, or Runmedian with StdMutex and Add() of every value.
+/// Counter reads is the rate of the polling thread.
+template <typename T, uint8_t kSize> void BM_Spsc(benchmark::State& state, Distribution distribution, bool spsc) {
+    constexpr size_t kBlock = 64;
+    const std::vector<T> samples = MakeSamples<T>(distribution);
+    common::RunmedianSpsc<T, kSize, 256> lock_free{};
+    common::Runmedian<T, kSize, common::StdMutex, common::IgnoreError> locked{};
+    std::atomic<bool> done{false};
+    uint64_t reads = 0;
+
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            benchmark::DoNotOptimize(spsc ? lock_free.Value() : locked.Value());
+            reads++;
+        }
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        for (size_t i = 0; i < samples.size(); i += kBlock) {
+            if (spsc) {
+                // the queue is longer than a block, so Push() does not fail
+                for (size_t j = i; j < i + kBlock; j++)
+                    lock_free.Push(samples[j]);
+                benchmark::DoNotOptimize(lock_free.Update());
+            } else {
+                for (size_t j = i; j < i + kBlock; j++)
+                    locked.Add(samples[j]);
+                benchmark::DoNotOptimize(locked.Value());
+            }
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    done.store(true);
+    reader.join();
+
+    SetCounters(state);
+    state.counters["reads"] = benchmark::Counter(seconds > 0.0 ? (double)reads / seconds : 0.0);
+}
+
+template <typename T, uint8_t kSize> void RegisterSpsc(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("Spsc" + suffix).c_str(), BM_Spsc<T, kSize>, distribution.id, true);
+        benchmark::RegisterBenchmark(("MutexAdd" + suffix).c_str(), BM_Spsc<T, kSize>, distribution.id, false);
+    }
+}
+
+template <typename T, uint8_t kSize> void RegisterWindow(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("Runmedian" + suffix).c_str(), BM_Median<common::Runmedian<T, kSize>, T>,
+                                     distribution.id);
+        benchmark::RegisterBenchmark(("NthElement" + suffix).c_str(), BM_Median<NthElementMedian<T, kSize>, T>,
+                                     distribution.id);
+        benchmark::RegisterBenchmark(("TwoHeap" + suffix).c_str(), BM_Median<common::RunmedianLarge<T, kSize>, T>,
+                                     distribution.id);
+        benchmark::RegisterBenchmark(("Rqueue" + suffix).c_str(), BM_Rqueue<T, kSize>, distribution.id);
+        benchmark::RegisterBenchmark(("Ingest" + suffix).c_str(), BM_Ingest<T, kSize>, distribution.id, false);
+        benchmark::RegisterBenchmark(("IngestBulk" + suffix).c_str(), BM_Ingest<T, kSize>, distribution.id, true);
+        benchmark::RegisterBenchmark(("Timed" + suffix).c_str(), BM_Timed<T, kSize>, distribution.id, false);
+        benchmark::RegisterBenchmark(("TimedBursts" + suffix).c_str(), BM_Timed<T, kSize>, distribution.id, true);
+        if constexpr (std::is_unsigned<T>::value && sizeof(T) <= 2U) {
+            benchmark::RegisterBenchmark(("Histogram" + suffix).c_str(),
+                                         BM_Median<common::RunmedianHistogram<T, kSize>, T>, distribution.id);
+        }
+    }
+}
+
+template <typename T, uint8_t kSize> void RegisterExtremes(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("Extremes" + suffix).c_str(),
+                                     BM_Extremes<common::RunExtremes<T, kSize, common::NoLock, common::IgnoreError>, T>,
+                                     distribution.id);
+        benchmark::RegisterBenchmark(("SortedExtremes" + suffix).c_str(), BM_Extremes<SortedExtremes<T, kSize>, T>,
+                                     distribution.id);
+    }
+}
+
+template <typename T, uint8_t kSize> void RegisterMad(const char* type_name) {
+    const std::string args = std::string("<") + type_name + "," + std::to_string(kSize) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const std::string suffix = args + distribution.name;
+        benchmark::RegisterBenchmark(("Mad" + suffix).c_str(),
+                                     BM_Mad<common::Runmedian<T, kSize, common::NoLock, common::IgnoreError>, T>,
+                                     distribution.id);
+        benchmark::RegisterBenchmark(("SortMad" + suffix).c_str(), BM_Mad<SortMad<T, kSize>, T>, distribution.id);
+    }
+}
+
+/// @brief The worst rank error of Remedian at the full window, as a fraction of the window.
+/// Samples are repeated to a long stream, the window is counted by a histogram of values.
+template <uint8_t kBase, uint8_t kLevels> double MeasureRankError(const std::vector<uint16_t>& samples) {
+    using Engine = common::Remedian<uint16_t, kBase, kLevels, common::NoLock, common::IgnoreError>;
+    const size_t window = (size_t)Engine::kWindow;
+    const size_t block = window / kBase;
+    auto engine = std::make_unique<Engine>();
+    std::vector<uint32_t> histogram(65536U);
+    double worst = 0.0;
+
+    for (size_t i = 0; i < 3U * window; i++) {
+        const uint16_t val = samples[i % samples.size()];
+        engine->Add(val);
+        histogram[val]++;
+        if (i >= window)
+            histogram[samples[(i - window) % samples.size()]]--;
+        if (i + 1U < window || (i + 1U) % block != 0U)
+            continue;
+
+        // ranks of the value are less..less+equal-1, the middle is (window - 1) / 2
+        const uint16_t median = engine->Value();
+        size_t less = 0;
+        for (uint32_t bin = 0; bin < median; bin++)
+            less += histogram[bin];
+        const size_t middle = (window - 1U) / 2U;
+        const size_t distance = middle < less ? less - middle
+                                : middle >= less + histogram[median] ? middle - (less + histogram[median] - 1U)
+                                                                     : 0U;
+        worst = std::max(worst, (double)distance / (double)window);
+    }
+
+    return worst;
+}
+
+template <typename TEngine> void BM_Approximate(benchmark::State& state, Distribution distribution, double error) {
+    const std::vector<uint16_t> samples = MakeSamples<uint16_t>(distribution);
+    auto engine = std::make_unique<TEngine>();
+
+    for (auto _ : state) {
+        for (const uint16_t val : samples) {
+            engine->Add(val);
+            benchmark::DoNotOptimize(engine->Value());
+        }
+    }
+
+    SetCounters(state);
+    state.counters["bytes"] = (double)sizeof(TEngine);
+    state.counters["rank_error"] = error;
+}
+
+template <uint8_t kBase, uint8_t kLevels> void RegisterApproximate() {
+    using Engine = common::Remedian<uint16_t, kBase, kLevels>;
+    using Exact = common::RunmedianLarge<uint16_t, (uint32_t)Engine::kWindow>;
+    const std::string args = "<uint16_t," + std::to_string(Engine::kWindow) + ">/";
+
+    for (const auto& distribution : kDistributions) {
+        const double error = MeasureRankError<kBase, kLevels>(MakeSamples<uint16_t>(distribution.id));
+        benchmark::RegisterBenchmark(("Remedian" + args + distribution.name).c_str(), BM_Approximate<Engine>,
+                                     distribution.id, error);
+        benchmark::RegisterBenchmark(("TwoHeap" + args + distribution.name).c_str(), BM_Approximate<Exact>,
+                                     distribution.id, 0.0);
+    }
+}
+
+constexpr size_t kChannels = 1000000;
+
+using CheckpointEngine = common::Runmedian<uint16_t, 19, common::NoLock, common::IgnoreError>;
+
+std::vector<uint8_t> MakeCheckpoint() {
+    const std::vector<uint16_t> samples = MakeSamples<uint16_t>(kRandom);
+    std::vector<CheckpointEngine> engines(kChannels);
+    for (size_t i = 0; i < kChannels; i++) {
+        for (size_t j = 0; j < 19U; j++)
+            engines[i].Add(samples[(i + j) % samples.size()]);
+    }
+
+    std::vector<uint8_t> checkpoint(common::CheckpointSize<CheckpointEngine>(kChannels));
+    common::SaveCheckpoint(engines.data(), kChannels, checkpoint.data(), checkpoint.size());
+    return checkpoint;
+}
+
+/// @brief Restart of kChannels channels: load of a checkpoint, use in place and replay of the last window of values.
+void BM_Restore(benchmark::State& state, int mode) {
+    const std::vector<uint8_t> checkpoint = MakeCheckpoint();
+    const std::vector<uint16_t> samples = MakeSamples<uint16_t>(kRandom);
+    std::vector<CheckpointEngine> engines(kChannels);
+
+    for (auto _ : state) {
+        if (mode == 0) {
+            common::LoadCheckpoint(checkpoint.data(), checkpoint.size(), engines.data(), kChannels);
+            benchmark::DoNotOptimize(engines.data());
+        } else if (mode == 1) {
+            size_t count = 0;
+            benchmark::DoNotOptimize(common::MapCheckpoint<CheckpointEngine>(
+                const_cast<uint8_t*>(checkpoint.data()), checkpoint.size(), &count));
+        } else {
+            for (size_t i = 0; i < kChannels; i++) {
+                engines[i].Clear();
+                for (size_t j = 0; j < 19U; j++)
+                    engines[i].Add(samples[(i + j) % samples.size()]);
+            }
+            benchmark::DoNotOptimize(engines.data());
+        }
+    }
+
+    state.counters["bytes"] = (double)checkpoint.size();
+}
+
+/// @brief Baseline of keyed channels: a heap allocated Runmedian per key at std::unordered_map.
+template <typename T, uint8_t kSize> class MapRegistry {
+  public:
+    explicit MapRegistry(uint32_t ttl) {
+        (void)ttl;
+    }
+
+    void Add(uint32_t key, T val, uint32_t now) {
+        (void)now;
+        auto& engine = map_[key];
+        if (!engine) {
+            engine = std::make_unique<common::Runmedian<T, kSize, common::NoLock, common::IgnoreError>>();
+        }
+        engine->Add(val);
+    }
+
+    T Value(uint32_t key) const {
+        return map_.at(key)->Value();
+    }
+
+  private:
+    std::unordered_map<uint32_t, std::unique_ptr<common::Runmedian<T, kSize, common::NoLock, common::IgnoreError>>>
+        map_;
+};
+
+/// @brief Add() and Value() of random channels out of a number of sparse keys (connection ids).
+template <typename TRegistry> void BM_Registry(benchmark::State& state, uint32_t keys) {
+    const std::vector<uint16_t> samples = MakeSamples<uint16_t>(kRandom);
+    std::mt19937 random(777U);
+    std::vector<uint32_t> ids(keys);
+    for (auto& id : ids)
+        id = (uint32_t)random();
+    std::vector<uint32_t> sequence(kSamples);
+    for (auto& key : sequence)
+        key = ids[random() % keys];
+
+    auto registry = std::make_unique<TRegistry>(1000000U);
+    uint32_t now = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < kSamples; i++) {
+            registry->Add(sequence[i], samples[i], now);
+            benchmark::DoNotOptimize(registry->Value(sequence[i]));
+        }
+        now++;
+    }
+
+    SetCounters(state);
+}
+
+template <uint8_t kSize> void RegisterRegistry(uint32_t keys) {
+    const std::string args = "<uint16_t," + std::to_string(kSize) + ">/" + std::to_string(keys) + "keys";
+
+    benchmark::RegisterBenchmark(
+        ("Registry" + args).c_str(),
+        BM_Registry<common::RunmedianRegistry<uint16_t, kSize, 4096, uint32_t, uint32_t, common::NoLock,
+                                              common::IgnoreError>>,
+        keys);
+    benchmark::RegisterBenchmark(("RegistrySharded" + args).c_str(),
+                                 BM_Registry<common::RunmedianRegistrySharded<uint16_t, kSize, 1024, 8>>, keys);
+    benchmark::RegisterBenchmark(("UnorderedMap" + args).c_str(), BM_Registry<MapRegistry<uint16_t, kSize>>, keys);
+}
+
+struct FrameSize {
+    uint32_t width;
+    uint32_t height;
+    const char* name;
+};
+
+constexpr FrameSize kFrames[] = {{640U, 480U, "640x480"}, {3840U, 2160U, "3840x2160"}};
+
+template <typename T> std::vector<T> MakeFrame(const FrameSize& frame) {
+    // noisy gradient, 12 bits for uint16_t
+    const uint32_t range = sizeof(T) == 1U ? 256U : 4096U;
+    std::mt19937 random(12345U);
+    std::vector<T> pixels((size_t)frame.width * frame.height);
+    for (uint32_t y = 0; y < frame.height; y++) {
+        for (uint32_t x = 0; x < frame.width; x++) {
+            const uint32_t val = (x * range / frame.width + random() % (range / 8U)) % range;
+            pixels[(size_t)y * frame.width + x] = (T)val;
+        }
+    }
+    return pixels;
+}
+
+void SetPixelCounters(benchmark::State& state, const FrameSize& frame) {
+    const double pixels = (double)frame.width * frame.height;
+    state.SetItemsProcessed((int64_t)(state.iterations() * pixels));
+    state.counters["per_pixel"] =
+        benchmark::Counter(pixels, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+template <typename T>
+void BM_MedianFilter2D(benchmark::State& state, FrameSize frame, uint32_t radius, uint32_t threads) {
+    const std::vector<T> in = MakeFrame<T>(frame);
+    std::vector<T> out(in.size());
+
+    for (auto _ : state) {
+        common::MedianFilter2D<T>(in.data(), out.data(), frame.width, frame.height, radius,
+                                  common::MedianBorder::kReplicate, 0, threads);
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    SetPixelCounters(state, frame);
+}
+
+/// @brief Baseline: Runmedian is filled again with the kernel for every pixel, O(radius^2) per pixel.
+template <typename T, uint32_t kRadius> void BM_Refill2D(benchmark::State& state, FrameSize frame) {
+    constexpr int kDiameter = 2 * (int)kRadius + 1;
+    const std::vector<T> in = MakeFrame<T>(frame);
+    std::vector<T> out(in.size());
+    common::Runmedian<T, (uint8_t)(kDiameter * kDiameter), common::NoLock, common::IgnoreError> engine{};
+    const int width = (int)frame.width;
+    const int height = (int)frame.height;
+
+    for (auto _ : state) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                engine.Clear();
+                for (int dy = -(int)kRadius; dy <= (int)kRadius; dy++) {
+                    const T* line = &in[(size_t)std::min(std::max(y + dy, 0), height - 1) * width];
+                    for (int dx = -(int)kRadius; dx <= (int)kRadius; dx++)
+                        engine.Add(line[std::min(std::max(x + dx, 0), width - 1)]);
+                }
+                out[(size_t)y * width + x] = engine.Value();
+            }
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    SetPixelCounters(state, frame);
+}
+
+template <typename T> void RegisterFrames(const char* type_name) {
+    for (const auto& frame : kFrames) {
+        for (uint32_t radius : {1U, 3U, 7U, 15U, 31U}) {
+            for (uint32_t threads : {1U, 0U}) {
+                const std::string name = std::string("MedianFilter2D<") + type_name + ",r" + std::to_string(radius) +
+                                         ">/" + frame.name + (threads == 1U ? "/threads:1" : "/threads:all");
+                benchmark::RegisterBenchmark(name.c_str(), BM_MedianFilter2D<T>, frame, radius, threads)
+                    ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+
+    // refilling is too slow for big frames and kernels
+    const std::string suffix = std::string("<") + type_name;
+    benchmark::RegisterBenchmark(("Refill2D" + suffix + ",r1>/640x480").c_str(), BM_Refill2D<T, 1U>, kFrames[0])
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("Refill2D" + suffix + ",r3>/640x480").c_str(), BM_Refill2D<T, 3U>, kFrames[0])
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("Refill2D" + suffix + ",r7>/640x480").c_str(), BM_Refill2D<T, 7U>, kFrames[0])
+        ->Unit(benchmark::kMillisecond);
+}
+
+template <typename T> void RegisterType(const char* type_name) {
+    RegisterWindow<T, 3>(type_name);
+    RegisterWindow<T, 5>(type_name);
+    RegisterWindow<T, 7>(type_name);
+    RegisterWindow<T, 9>(type_name);
+    RegisterWindow<T, 19>(type_name);
+    RegisterWindow<T, 64>(type_name);
+    RegisterWindow<T, 255>(type_name);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // names are "Engine<type,window>/distribution", so --benchmark_filter=Runmedian<float selects one group
+    RegisterType<uint8_t>("uint8_t");
+    RegisterType<uint16_t>("uint16_t");
+    RegisterType<int32_t>("int32_t");
+    RegisterType<float>("float");
+    RegisterType<double>("double");
+    benchmark::RegisterBenchmark("Restore<uint16_t,19>/1000000/load", BM_Restore, 0)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Restore<uint16_t,19>/1000000/map", BM_Restore, 1)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Restore<uint16_t,19>/1000000/replay", BM_Restore, 2)->Unit(benchmark::kMillisecond);
+    RegisterDecimate<uint16_t, 64, 10>("uint16_t");
+    RegisterDecimate<uint16_t, 255, 10>("uint16_t");
+    RegisterDecimate<uint16_t, 255, 32>("uint16_t");
+    RegisterDecimate<uint16_t, 255, 100>("uint16_t");
+    RegisterDecimate<float, 64, 10>("float");
+    RegisterDecimate<float, 255, 10>("float");
+    RegisterDecimate<float, 255, 32>("float");
+    RegisterDecimate<float, 255, 100>("float");
+    RegisterExtremes<uint16_t, 19>("uint16_t");
+    RegisterExtremes<uint16_t, 255>("uint16_t");
+    RegisterExtremes<float, 64>("float");
+    RegisterBank<uint16_t, 7, 64>("uint16_t");
+    RegisterBank<uint16_t, 19, 256>("uint16_t");
+    RegisterBank<float, 19, 256>("float");
+    RegisterSpsc<uint16_t, 19>("uint16_t");
+    RegisterSpsc<int32_t, 19>("int32_t");
+    RegisterSpsc<float, 64>("float");
+    RegisterRegistry<19>(100);
+    RegisterRegistry<19>(3000);
+    RegisterMad<uint16_t, 19>("uint16_t");
+    RegisterMad<uint16_t, 64>("uint16_t");
+    RegisterMad<uint16_t, 255>("uint16_t");
+    RegisterMad<float, 64>("float");
+#ifdef RUNMEDIAN_RANGES
+    RegisterView<uint16_t, 19>("uint16_t");
+    RegisterView<uint16_t, 64>("uint16_t");
+    RegisterView<float, 64>("float");
+#endif
+    RegisterApproximate<15, 3>();
+    RegisterApproximate<15, 5>();
+    RegisterFrames<uint8_t>("uint8_t");
+    RegisterFrames<uint16_t>("uint16_t");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,520 @@
+#include "include/medfilter.hpp"
+#include "include/rmtrace.hpp"
+#include "include/runmedian.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Running median of a recorded trace:
+//
+//   RunMedianCli [options] [input]
+//
+// Binary input is raw little-endian values, records of --columns values, file input is mapped to memory and
+// read once from start to end. A mapped file of one column with hop 1 is filtered in place by threads of
+// common::RunningMedian(). Text input is CSV (',', ';' or tab separated), one record per line, lines whose
+// field at --column is not entirely a number of --type are skipped (a header, 1.9 for int32). A file which
+// cannot be mapped and stdin are read by big blocks. Medians go to --output or stdout through a big buffer,
+// by default in the format of the input: raw values of the input type for binary input, one number per line
+// for text input. Throughput is reported at stderr.
+
+namespace {
+
+constexpr size_t kParallelChunk = 1U << 16; // values per thread and common::RunningMedian() call, they stay in cache
+
+enum class ValueKind { kInt16, kUint16, kInt32, kFloat, kDouble };
+
+struct ValueKindInfo {
+    ValueKind id;
+    const char* name;
+};
+
+constexpr ValueKindInfo kValueKinds[] = {
+    {ValueKind::kInt16, "int16"}, {ValueKind::kUint16, "uint16"}, {ValueKind::kInt32, "int32"},
+    {ValueKind::kFloat, "float"}, {ValueKind::kDouble, "double"},
+};
+
+// Runmedian takes its window as a template argument, so only these windows are compiled in.
+template <uint8_t... kWindows> struct WindowList {};
+using SupportedWindows = WindowList<1, 2, 3, 4, 5, 7, 8, 9, 10, 11, 15, 16, 19, 20, 21, 25, 31, 32, 33, 50, 51, 63, 64,
+                                    65, 99, 100, 101, 127, 128, 151, 199, 200, 201, 255>;
+
+struct Options {
+    const char* input = nullptr;  // nullptr or "-" for stdin
+    const char* output = nullptr; // nullptr or "-" for stdout
+    ValueKind kind = ValueKind::kInt16;
+    bool csv = false;
+    bool text_out = false;
+    bool out_format_set = false;
+    bool quiet = false;
+    unsigned long window = 5;
+    unsigned long hop = 1;
+    unsigned long column = 0;
+    unsigned long columns = 1;
+    unsigned long threads = 0; // 0 for all cores
+};
+
+template <uint8_t... kWindows> void PrintWindows(FILE* file, WindowList<kWindows...>) {
+    ((void)std::fprintf(file, " %u", (unsigned)kWindows), ...);
+}
+
+void PrintUsage(FILE* file) {
+    std::fprintf(file,
+                 "Usage: RunMedianCli [options] [input]\n"
+                 "  input               file to read, stdin if it is - or missing\n"
+                 "  -t, --type T        int16 | uint16 | int32 | float | double (default int16)\n"
+                 "  -c, --csv           input is text, comma, semicolon or tab separated, one record per line\n"
+                 "  -w, --window N      window length (default 5), one of:");
+    PrintWindows(file, SupportedWindows{});
+    std::fprintf(file,
+                 "\n"
+                 "  -p, --hop N         write every N-th median (default 1)\n"
+                 "  -k, --column N      column of the value in a record, from 0 (default 0)\n"
+                 "  -n, --columns N     values per record of binary input (default 1)\n"
+                 "  -j, --threads N     threads for a mapped file of one column and hop 1 (default 0, all cores)\n"
+                 "  -o, --output F      file for medians, stdout if it is - or missing\n"
+                 "  -f, --format F      bin | text, format of medians (default is the format of the input)\n"
+                 "  -q, --quiet         do not report throughput\n"
+                 "  -h, --help          print this help\n");
+}
+
+bool ParseNumber(const char* text, unsigned long& value) {
+    const char* end = text + std::strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end && *text != '\0';
+}
+
+/**
+ * @brief Parses command line, prints a reason and returns false for a wrong one.
+ */
+bool ParseOptions(int argc, char** argv, Options& options, bool& help) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        auto number = [&](unsigned long& out) {
+            const char* text = value();
+            if (text == nullptr || !ParseNumber(text, out)) {
+                std::fprintf(stderr, "RunMedianCli: %s needs a number\n", arg.c_str());
+                return false;
+            }
+            return true;
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            help = true;
+            return true;
+        } else if (arg == "-t" || arg == "--type") {
+            const char* text = value();
+            const ValueKindInfo* found = nullptr;
+            for (const auto& info : kValueKinds) {
+                if (text != nullptr && std::strcmp(text, info.name) == 0) {
+                    found = &info;
+                }
+            }
+            if (found == nullptr) {
+                std::fprintf(stderr, "RunMedianCli: unknown type %s\n", text != nullptr ? text : "");
+                return false;
+            }
+            options.kind = found->id;
+        } else if (arg == "-c" || arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "-w" || arg == "--window") {
+            if (!number(options.window)) {
+                return false;
+            }
+        } else if (arg == "-p" || arg == "--hop") {
+            if (!number(options.hop)) {
+                return false;
+            }
+        } else if (arg == "-k" || arg == "--column") {
+            if (!number(options.column)) {
+                return false;
+            }
+        } else if (arg == "-n" || arg == "--columns") {
+            if (!number(options.columns)) {
+                return false;
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            if (!number(options.threads)) {
+                return false;
+            }
+        } else if (arg == "-o" || arg == "--output") {
+            options.output = value();
+            if (options.output == nullptr) {
+                std::fprintf(stderr, "RunMedianCli: %s needs a file name\n", arg.c_str());
+                return false;
+            }
+        } else if (arg == "-f" || arg == "--format") {
+            const char* text = value();
+            if (text == nullptr || (std::strcmp(text, "bin") != 0 && std::strcmp(text, "text") != 0)) {
+                std::fprintf(stderr, "RunMedianCli: format must be bin or text\n");
+                return false;
+            }
+            options.text_out = std::strcmp(text, "text") == 0;
+            options.out_format_set = true;
+        } else if (arg == "-q" || arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::fprintf(stderr, "RunMedianCli: unknown option %s\n", arg.c_str());
+            return false;
+        } else if (options.input == nullptr) {
+            options.input = argv[i];
+        } else {
+            std::fprintf(stderr, "RunMedianCli: more than one input\n");
+            return false;
+        }
+    }
+
+    if (!options.out_format_set) {
+        options.text_out = options.csv;
+    }
+    if (options.hop == 0 || options.columns == 0 || (options.column >= options.columns && !options.csv)) {
+        std::fprintf(stderr, "RunMedianCli: hop and columns must be positive, column must be less than columns\n");
+        return false;
+    }
+    return true;
+}
+
+bool IsStdio(const char* name) {
+    return name == nullptr || std::strcmp(name, "-") == 0;
+}
+
+/// @brief Read-only memory map of a whole file.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    /**
+     * @brief Maps a file, returns false if it cannot be mapped (a pipe, no address space).
+     */
+    bool Open(const char* name) {
+#ifdef _WIN32
+        file_ = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+            return false;
+        }
+        size_ = (size_t)size.QuadPart;
+        if (size_ == 0) {
+            return true;
+        }
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            return false;
+        }
+        data_ = (const unsigned char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        return data_ != nullptr;
+#else
+        const int fd = open(name, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || (uint64_t)info.st_size > (uint64_t)SIZE_MAX) {
+            close(fd);
+            return false;
+        }
+        size_ = (size_t)info.st_size;
+        if (size_ == 0) {
+            close(fd);
+            return true;
+        }
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        // pages are touched once in order: read ahead and drop them early
+        (void)madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = (const unsigned char*)data;
+        return true;
+#endif
+    }
+
+    const unsigned char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+  private:
+    void Close() {
+#ifdef _WIN32
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+        }
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_ != nullptr) {
+            munmap((void*)data_, size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// @brief Running median of the selected values, writes every hop-th median.
+template <typename T, uint8_t kWindow> class MedianPipeline {
+  public:
+    MedianPipeline(unsigned long hop, common::TraceWriter<T>& writer, common::TraceStats& stats)
+        : hop_(hop), writer_(writer), stats_(stats) {}
+
+    /**
+     * @brief Adds values, returns false for a write error.
+     */
+    bool Push(const T* values, size_t count) {
+        stats_.values += count;
+        if (hop_ == 1U) {
+            engine_.AddBatch(values, count, medians_);
+            return writer_.Put(medians_, count);
+        }
+        // hops are counted across calls, a median is taken after every hop-th value
+        size_t ready = 0;
+        for (size_t i = 0; i < count;) {
+            const size_t take = (std::min)(count - i, (size_t)(hop_ - phase_));
+            engine_.AddBatch(values + i, take);
+            i += take;
+            phase_ += take;
+            if (phase_ == hop_) {
+                medians_[ready++] = engine_.Value();
+                phase_ = 0;
+            }
+        }
+        return writer_.Put(medians_, ready);
+    }
+
+    /**
+     * @brief Adds all values of the input with hop 1 by threads, the pipeline must be empty; returns false for
+     * a write error.
+     */
+    bool PushAll(const T* values, size_t count, uint32_t threads) {
+        stats_.values += count;
+        if (threads == 0U) {
+            threads = (std::max)(1U, std::thread::hardware_concurrency());
+        }
+        // a block starts with kWindow - 1 values before it, so its medians are the same as sequential ones
+        const size_t block = kParallelChunk * threads;
+        std::vector<T> medians((std::min)(count, block) + kWindow);
+        for (size_t begin = 0; begin < count; begin += block) {
+            const size_t warm = (std::min)(begin, (size_t)kWindow - 1U);
+            const size_t take = (std::min)(count - begin, block);
+            common::RunningMedian<T, kWindow>(values + begin - warm, warm + take, medians.data(), threads);
+            if (!writer_.Put(medians.data() + warm, take)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    common::Runmedian<T, kWindow, common::NoLock, common::IgnoreError> engine_;
+    unsigned long hop_;
+    unsigned long phase_ = 0;
+    common::TraceWriter<T>& writer_;
+    common::TraceStats& stats_;
+    T medians_[common::kTraceBatch];
+};
+
+/**
+ * @brief Runs one input through a decoder: the whole mapped file at once or a stream by blocks.
+ */
+template <typename T, typename TPipeline>
+bool ProcessInput(const Options& options, TPipeline& pipeline, common::TraceStats& stats) {
+    bool ok = true;
+    auto decode = [&](const unsigned char* data, size_t size, bool last) {
+        if (options.csv) {
+            return common::DecodeTextTrace<T>((const char*)data, size, last, options.column, pipeline, stats, ok);
+        }
+        return common::DecodeBinaryTrace<T>(data, size, options.column, options.columns, pipeline, ok);
+    };
+
+    if (!IsStdio(options.input)) {
+        MappedFile mapped;
+        if (mapped.Open(options.input)) {
+            // raw values of one column are the input of the filter as they are
+            if (!options.csv && options.columns == 1U && options.hop == 1U && common::IsLittleEndianHost() &&
+                (uintptr_t)mapped.Data() % alignof(T) == 0U) {
+                ok = pipeline.PushAll((const T*)mapped.Data(), mapped.Size() / sizeof(T), (uint32_t)options.threads);
+            } else {
+                decode(mapped.Data(), mapped.Size(), true);
+            }
+            stats.bytes_in = mapped.Size();
+            return ok;
+        }
+    }
+
+    FILE* file = stdin;
+    if (!IsStdio(options.input)) {
+        file = std::fopen(options.input, "rb");
+        if (file == nullptr) {
+            std::fprintf(stderr, "RunMedianCli: cannot open %s\n", options.input);
+            return false;
+        }
+    }
+#ifdef _WIN32
+    else {
+        _setmode(_fileno(stdin), _O_BINARY);
+    }
+#endif
+    // a partial record or line stays at the start of the buffer for the next block
+    std::vector<unsigned char> buffer(2U * common::kTraceBlock);
+    size_t kept = 0;
+    while (ok) {
+        if (kept == buffer.size()) {
+            buffer.resize(buffer.size() * 2U); // a line longer than a block
+        }
+        const size_t got = std::fread(buffer.data() + kept, 1, buffer.size() - kept, file);
+        stats.bytes_in += got;
+        const bool last = got == 0U;
+        const size_t used = decode(buffer.data(), kept + got, last);
+        kept = kept + got - used;
+        std::memmove(buffer.data(), buffer.data() + used, kept);
+        if (last) {
+            break;
+        }
+    }
+    if (std::ferror(file)) {
+        std::fprintf(stderr, "RunMedianCli: read error\n");
+        ok = false;
+    }
+    if (file != stdin) {
+        std::fclose(file);
+    }
+    return ok;
+}
+
+template <typename T, uint8_t kWindow> int Run(const Options& options, common::TraceStats& stats) {
+    FILE* file = stdout;
+    if (!IsStdio(options.output)) {
+        file = std::fopen(options.output, "wb");
+        if (file == nullptr) {
+            std::fprintf(stderr, "RunMedianCli: cannot create %s\n", options.output);
+            return 1;
+        }
+    }
+#ifdef _WIN32
+    else if (!options.text_out) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+    // writes are kTraceBlock already, stdio buffering would only copy them
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    // both are big for a stack
+    auto writer = std::make_unique<common::TraceWriter<T>>(file, options.text_out, stats);
+    auto pipeline = std::make_unique<MedianPipeline<T, kWindow>>(options.hop, *writer, stats);
+    bool ok = ProcessInput<T>(options, *pipeline, stats);
+    bool written = writer->Flush();
+    if (file != stdout) {
+        written = (std::fclose(file) == 0) && written;
+    }
+    if (!written) {
+        std::fprintf(stderr, "RunMedianCli: write error\n");
+    }
+    return (ok && written) ? 0 : 1;
+}
+
+template <typename T, uint8_t kWindow, uint8_t... kRest>
+int DispatchWindow(const Options& options, common::TraceStats& stats, WindowList<kWindow, kRest...>) {
+    if (options.window == kWindow) {
+        return Run<T, kWindow>(options, stats);
+    }
+    if constexpr (sizeof...(kRest) > 0U) {
+        return DispatchWindow<T>(options, stats, WindowList<kRest...>{});
+    } else {
+        std::fprintf(stderr, "RunMedianCli: window %lu is not supported, one of:", options.window);
+        PrintWindows(stderr, SupportedWindows{});
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+}
+
+int Dispatch(const Options& options, common::TraceStats& stats) {
+    switch (options.kind) {
+    case ValueKind::kInt16:
+        return DispatchWindow<int16_t>(options, stats, SupportedWindows{});
+    case ValueKind::kUint16:
+        return DispatchWindow<uint16_t>(options, stats, SupportedWindows{});
+    case ValueKind::kInt32:
+        return DispatchWindow<int32_t>(options, stats, SupportedWindows{});
+    case ValueKind::kFloat:
+        return DispatchWindow<float>(options, stats, SupportedWindows{});
+    case ValueKind::kDouble:
+        return DispatchWindow<double>(options, stats, SupportedWindows{});
+    }
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool help = false;
+    if (!ParseOptions(argc, argv, options, help)) {
+        PrintUsage(stderr);
+        return 2;
+    }
+    if (help) {
+        PrintUsage(stdout);
+        return 0;
+    }
+
+    common::TraceStats stats;
+    const auto start = std::chrono::steady_clock::now();
+    const int result = Dispatch(options, stats);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!options.quiet) {
+        const double rate = seconds > 0.0 ? 1.0 / seconds : 0.0;
+        std::fprintf(stderr,
+                     "%llu values, %llu medians, %.1f MB in, %.1f MB out, %.3f s: %.1f MB/s, %.2f M values/s\n",
+                     (unsigned long long)stats.values, (unsigned long long)stats.medians, stats.bytes_in / 1e6,
+                     stats.bytes_out / 1e6, seconds, stats.bytes_in / 1e6 * rate, stats.values / 1e6 * rate);
+        if (stats.skipped > 0U) {
+            std::fprintf(stderr, "%llu lines without a value are skipped\n", (unsigned long long)stats.skipped);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,104 @@
+// HAMPEL_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Hampel filter: running median and running MAD (median absolute deviation) for spike rejection
+///
+/// Every value is added to a Runmedian window of the last kSize values (outliers too, the window keeps raw values).
+/// A value is an outlier when |value - median| > k_sigma * kMadScale * MAD, where median and MAD are taken over
+/// the window with the value. MAD comes from the sorted window of Runmedian by binary search (see Runmedian::Mad()),
+/// so there is no copy and no sort of deviations on every value.
+/// An outlier is replaced by the median, others pass as they are.
+/// MAD of a flat window is 0, so any change of a flat signal is an outlier, as for the classic filter.
+///
+/// LockPolicy and ErrorPolicy are the same as for Runmedian.
+template <typename TRMValueType, const uint8_t kSize, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class Hampel : private LockPolicy, private ErrorPolicy {
+  public:
+    Hampel() = default;
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(kSize > 0U, "kSize must be in range 1..255");
+
+    /**
+     * @brief MAD of normally distributed values times kMadScale is their standard deviation
+     */
+    static constexpr double kMadScale = 1.4826;
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief Adds a value and returns it or the running median, if the value is an outlier.
+     *
+     * @param val another value.
+     * @param k_sigma threshold in standard deviations (3.0 is usual).
+     * @param outlier if not nullptr, receives true for an outlier.
+     */
+    TRMValueType Filter(TRMValueType val, double k_sigma, bool* outlier = nullptr);
+
+    /**
+     * @brief Filters a number of values under one lock, the same as Filter() for every value.
+     *
+     * @param in values to filter.
+     * @param out if not nullptr, receives values with outliers replaced by running median (count items),
+     * it may be the same as in.
+     * @param count count of values.
+     * @param k_sigma threshold in standard deviations (3.0 is usual).
+     * @param outliers if not nullptr, receives true for outliers and false for others (count items).
+     * @return count of outliers.
+     */
+    size_t Filter(const TRMValueType* in, TRMValueType* out, size_t count, double k_sigma, bool* outliers = nullptr);
+
+    /**
+     * @brief running median value
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief running median absolute deviation, it is not scaled by kMadScale
+     */
+    TRMValueType Mad() const;
+
+    /**
+     * @brief Returns a size of values set, being used for calculating running median.
+     */
+    uint8_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks the window
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    TRMValueType Push(TRMValueType val, double k_sigma, bool* outlier);
+
+    Runmedian<TRMValueType, kSize, NoLock, IgnoreError> window_{};
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "hampel.inl"
+
+// HAMPEL_END
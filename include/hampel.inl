@@ -0,0 +1,127 @@
+// HAMPEL_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "hampel.hpp"
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                             LockCb lock_cb,
+                                                                             UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Push(TRMValueType val, double k_sigma,
+                                                                        bool* outlier) {
+    window_.Add(val);
+    const TRMValueType median = window_.Value();
+    const TRMValueType mad = window_.Mad();
+
+    // deviation is compared as double, so it does not overflow for integral values
+    const double deviation = val < median ? (double)median - (double)val : (double)val - (double)median;
+    const bool is_outlier = deviation > k_sigma * kMadScale * (double)mad;
+    if (outlier != nullptr) {
+        *outlier = is_outlier;
+    }
+
+    return is_outlier ? median : val;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Filter(TRMValueType val, double k_sigma,
+                                                                          bool* outlier) {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = Push(val, k_sigma, outlier);
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+size_t Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Filter(const TRMValueType* in, TRMValueType* out,
+                                                                    size_t count, double k_sigma, bool* outliers) {
+    HANDLE_ERROR(in != nullptr || count == 0U, 0U);
+
+    size_t found = 0;
+
+    CONTAINER_LOCK();
+    for (size_t i = 0; i < count; i++) {
+        bool outlier = false;
+        const TRMValueType val = Push(in[i], k_sigma, &outlier);
+        if (out != nullptr) {
+            out[i] = val;
+        }
+        if (outliers != nullptr) {
+            outliers[i] = outlier;
+        }
+        found += outlier ? 1U : 0U;
+    }
+    CONTAINER_UNLOCK();
+
+    return found;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Value() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = window_.Value();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Mad() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = window_.Mad();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint8_t Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Size() const {
+    return window_.Size();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return window_.IsEmpty();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    window_.Clear();
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool Hampel<TRMValueType, kSize, LockPolicy, ErrorPolicy>::_check_integrity() {
+    return window_._check_integrity();
+}
+
+} // namespace common
+
+// HAMPEL_INL
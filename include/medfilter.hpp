@@ -0,0 +1,41 @@
+// MEDFILTER_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include "runmedianlarge.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+
+namespace common {
+
+/**
+ * @brief Offline running median of the whole array (median filter).
+ *
+ * out[i] is the same value as Value() of Runmedian<TRMValueType, kSize> after Add() of in[0]..in[i],
+ * including the first kSize - 1 values, when the window is not full yet.
+ * The array is split to chunks, which are processed by threads in parallel. Every chunk but the first
+ * one warms its own engine up with kSize - 1 values before the chunk, so results are bit-identical
+ * to the sequential processing. Chunks of threads, which cannot be started, are processed by the calling thread.
+ *
+ * @param in values, must not overlap with out.
+ * @param count count of values.
+ * @param out running medians (count items).
+ * @param threads number of threads, 0 means std::thread::hardware_concurrency().
+ * @return false for wrong parameters.
+ */
+template <typename TRMValueType, uint8_t kSize>
+bool RunningMedian(const TRMValueType* in, size_t count, TRMValueType* out, uint32_t threads = 0);
+
+/**
+ * @brief The same as RunningMedian(), but with RunmedianLarge engine for windows longer than 255 values.
+ */
+template <typename TRMValueType, uint32_t kSize>
+bool RunningMedianLarge(const TRMValueType* in, size_t count, TRMValueType* out, uint32_t threads = 0);
+
+} // namespace common
+
+// Here comes the implementation.
+#include "medfilter.inl"
+
+// MEDFILTER_END
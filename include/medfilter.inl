@@ -0,0 +1,87 @@
+// MEDFILTER_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "medfilter.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+namespace detail {
+
+// Chunks smaller than this are not worth a thread
+constexpr size_t kMedFilterMinChunk = 65536U;
+
+template <typename TEngine, typename TRMValueType>
+void RunningMedianChunk(const TRMValueType* in, size_t begin, size_t end, size_t window, TRMValueType* out) {
+    // engine may be too big for a stack
+    std::unique_ptr<TEngine> engine = std::make_unique<TEngine>();
+
+    // the window before the chunk, as it would be at sequential processing
+    const size_t warm = std::min(begin, window - 1U);
+    engine->AddBatch(in + begin - warm, warm);
+    engine->AddBatch(in + begin, end - begin, out + begin);
+}
+
+template <typename TEngine, typename TRMValueType>
+bool RunningMedian(const TRMValueType* in, size_t count, TRMValueType* out, size_t window, uint32_t threads) {
+    if (count == 0U)
+        return true;
+    if (in == nullptr || out == nullptr)
+        return false;
+
+    if (threads == 0U)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+
+    // every chunk pays for warm up with window - 1 values, so keep chunks much longer than the window
+    const size_t min_chunk = std::max(kMedFilterMinChunk, window * 16U);
+    const size_t chunks = std::max<size_t>(1U, std::min<size_t>(threads, count / min_chunk));
+    const size_t chunk = (count + chunks - 1U) / chunks;
+
+    if (chunks == 1U) {
+        RunningMedianChunk<TEngine>(in, 0U, count, window, out);
+        return true;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1U);
+    size_t begin = chunk;
+    try {
+        for (; begin < count; begin += chunk) {
+            workers.emplace_back(RunningMedianChunk<TEngine, TRMValueType>, in, begin, std::min(begin + chunk, count),
+                                 window, out);
+        }
+    } catch (const std::system_error&) {
+        // no more threads, chunks from begin are left for this thread; started workers are joined below
+    }
+    RunningMedianChunk<TEngine>(in, 0U, chunk, window, out);
+    for (; begin < count; begin += chunk)
+        RunningMedianChunk<TEngine>(in, begin, std::min(begin + chunk, count), window, out);
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    return true;
+}
+
+} // namespace detail
+
+template <typename TRMValueType, uint8_t kSize>
+bool RunningMedian(const TRMValueType* in, size_t count, TRMValueType* out, uint32_t threads) {
+    return detail::RunningMedian<Runmedian<TRMValueType, kSize, NoLock, IgnoreError>>(in, count, out, kSize, threads);
+}
+
+template <typename TRMValueType, uint32_t kSize>
+bool RunningMedianLarge(const TRMValueType* in, size_t count, TRMValueType* out, uint32_t threads) {
+    return detail::RunningMedian<RunmedianLarge<TRMValueType, kSize, NoLock, IgnoreError>>(in, count, out, kSize,
+                                                                                          threads);
+}
+
+} // namespace common
+
+// MEDFILTER_INL
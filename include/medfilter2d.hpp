@@ -0,0 +1,50 @@
+// MEDFILTER2D_HPP
+#pragma once
+
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief How pixels out of the frame are taken for the kernel near the border
+enum class MedianBorder : uint8_t {
+    kReplicate, // the nearest edge pixel: aaa|abcd|ddd
+    kReflect,   // mirrored at the edge pixel: dcb|abcd|cba
+    kConstant,  // the given constant value
+};
+
+/**
+ * @brief Median filter of a frame (thermal array, depth map, gray image) with square kernel of 2 * radius + 1.
+ *
+ * It is the constant time filter of Perreault and Hebert: every column of the frame has a histogram of its
+ * 2 * radius + 1 pixels, which is moved down by one row with one decrement and one increment, and the kernel
+ * histogram is moved right by adding one column histogram and subtracting another one. Histograms have two
+ * levels (coarse bins of the high bits and fine bins of the low bits), fine bins of the kernel are updated lazily,
+ * only for the coarse bin with the median. So the cost of a pixel does not depend on the radius.
+ *
+ * Every pixel of the kernel exists (see MedianBorder), so the median is one of pixels, there is no averaging.
+ * The frame is split to strips of rows, which are processed by threads in parallel, and to tiles of columns,
+ * so column histograms of a tile fit into the cache. Results do not depend on the count of threads.
+ * Strips of threads, which cannot be started, are processed by the calling thread.
+ *
+ * @param in pixels row by row, width * height items, must not overlap with out.
+ * @param out filtered pixels, width * height items.
+ * @param width width of the frame.
+ * @param height height of the frame.
+ * @param radius radius of the kernel, 0..127.
+ * @param border pixels out of the frame.
+ * @param constant pixel value for MedianBorder::kConstant.
+ * @param threads number of threads, 0 means std::thread::hardware_concurrency().
+ * @return false for wrong parameters and for pixels not less than 2^kBits (they are taken as 2^kBits - 1).
+ */
+template <typename TPixel, uint32_t kBits = sizeof(TPixel) == 1U ? 8U : 12U>
+bool MedianFilter2D(const TPixel* in, TPixel* out, uint32_t width, uint32_t height, uint32_t radius,
+                    MedianBorder border = MedianBorder::kReplicate, TPixel constant = 0, uint32_t threads = 0);
+
+} // namespace common
+
+// Here comes the implementation.
+#include "medfilter2d.inl"
+
+// MEDFILTER2D_END
@@ -0,0 +1,236 @@
+// MEDFILTER2D_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "medfilter2d.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+namespace detail {
+
+// Strips lower than this are not worth a thread
+constexpr uint32_t kMedFilter2DMinStrip = 32U;
+// Column histograms of one tile, about a size of L2 cache
+constexpr size_t kMedFilter2DTileBytes = 1U << 18;
+// Kernel counts are uint16_t, (2 * 127 + 1)^2 fits
+constexpr uint32_t kMedFilter2DMaxRadius = 127U;
+
+struct MedianFilter2DFrame {
+    uint32_t width;
+    uint32_t height;
+    uint32_t radius;
+    MedianBorder border;
+};
+
+// Index of a pixel for a coordinate out of the frame, -1 for the constant border
+inline int64_t MedianBorderIndex(int64_t pos, int64_t size, MedianBorder border) {
+    if (pos >= 0 && pos < size)
+        return pos;
+
+    switch (border) {
+    case MedianBorder::kReplicate:
+        return pos < 0 ? 0 : size - 1;
+    case MedianBorder::kReflect: {
+        if (size == 1)
+            return 0;
+        // a kernel wider than the frame is reflected again
+        const int64_t period = 2 * (size - 1);
+        pos %= period;
+        if (pos < 0)
+            pos += period;
+        return pos < size ? pos : period - pos;
+    }
+    default:
+        return -1;
+    }
+}
+
+template <typename TPixel, uint32_t kBits>
+void MedianFilter2DStrip(const TPixel* in, TPixel* out, const MedianFilter2DFrame& frame, TPixel constant,
+                         uint32_t y_begin, uint32_t y_end, bool* out_of_range) {
+    constexpr uint32_t kBins = 1U << kBits;
+    constexpr uint32_t kFineBits = (kBits + 1U) / 2U;
+    constexpr uint32_t kFine = 1U << kFineBits; // fine bins of one coarse bin
+    constexpr uint32_t kCoarse = kBins >> kFineBits;
+
+    const uint32_t radius = frame.radius;
+    const uint32_t diameter = 2U * radius + 1U;
+    const uint32_t rank = (diameter * diameter - 1U) / 2U;
+
+    // a tile is much wider than the kernel, otherwise columns out of the tile are counted too often
+    const uint32_t tile = std::min<uint32_t>(
+        frame.width, std::max<uint32_t>((uint32_t)(kMedFilter2DTileBytes / (kBins * sizeof(uint16_t))), 4U * diameter));
+    const uint32_t columns = tile + 2U * radius;
+
+    std::vector<uint16_t> column_fine((size_t)columns * kBins);
+    std::vector<uint16_t> column_coarse((size_t)columns * kCoarse);
+    std::vector<int64_t> source_x(columns);
+    std::vector<uint16_t> kernel_fine(kBins);
+    uint16_t kernel_coarse[kCoarse];
+    int64_t updated[kCoarse]; // column of the kernel, when fine bins of a coarse bin were valid
+
+    bool clamped = false;
+    auto bin_of = [&clamped](TPixel pixel) -> uint32_t {
+        if constexpr (kBits < sizeof(TPixel) * 8U) {
+            if (pixel >= kBins) {
+                clamped = true;
+                return kBins - 1U;
+            }
+        }
+        return (uint32_t)pixel;
+    };
+
+    for (uint32_t x_begin = 0; x_begin < frame.width; x_begin += tile) {
+        const uint32_t count = std::min(tile, frame.width - x_begin);
+        const uint32_t used = count + 2U * radius;
+
+        for (uint32_t j = 0; j < used; j++) {
+            source_x[j] = MedianBorderIndex((int64_t)x_begin - radius + j, frame.width, frame.border);
+        }
+        memset(column_fine.data(), 0, (size_t)used * kBins * sizeof(uint16_t));
+        memset(column_coarse.data(), 0, (size_t)used * kCoarse * sizeof(uint16_t));
+
+        // adds (delta 1) or removes (delta 0xFFFF) a row of the frame to column histograms
+        auto update_columns = [&](int64_t y, uint16_t delta) {
+            const int64_t source_y = MedianBorderIndex(y, frame.height, frame.border);
+            const TPixel* line = source_y < 0 ? nullptr : in + (size_t)source_y * frame.width;
+            for (uint32_t j = 0; j < used; j++) {
+                const TPixel pixel = (line == nullptr || source_x[j] < 0) ? constant : line[source_x[j]];
+                const uint32_t bin = bin_of(pixel);
+                uint16_t& fine = column_fine[(size_t)j * kBins + bin];
+                uint16_t& coarse = column_coarse[(size_t)j * kCoarse + (bin >> kFineBits)];
+                fine = (uint16_t)(fine + delta);
+                coarse = (uint16_t)(coarse + delta);
+            }
+        };
+
+        for (int64_t y = (int64_t)y_begin - radius; y <= (int64_t)y_begin + radius; y++) {
+            update_columns(y, 1U);
+        }
+
+        for (uint32_t y = y_begin; y < y_end; y++) {
+            if (y > y_begin) {
+                update_columns((int64_t)y - radius - 1, 0xFFFFU);
+                update_columns((int64_t)y + radius, 1U);
+            }
+
+            memset(kernel_coarse, 0, sizeof(kernel_coarse));
+            for (uint32_t j = 0; j < diameter; j++) {
+                const uint16_t* coarse = &column_coarse[(size_t)j * kCoarse];
+                for (uint32_t c = 0; c < kCoarse; c++)
+                    kernel_coarse[c] = (uint16_t)(kernel_coarse[c] + coarse[c]);
+            }
+            for (uint32_t c = 0; c < kCoarse; c++)
+                updated[c] = -1;
+
+            TPixel* out_line = out + (size_t)y * frame.width + x_begin;
+            for (uint32_t i = 0; i < count; i++) {
+                // the kernel of pixel i has columns i..i + 2 * radius of the tile
+                if (i > 0U) {
+                    const uint16_t* add = &column_coarse[(size_t)(i + 2U * radius) * kCoarse];
+                    const uint16_t* sub = &column_coarse[(size_t)(i - 1U) * kCoarse];
+                    for (uint32_t c = 0; c < kCoarse; c++)
+                        kernel_coarse[c] = (uint16_t)(kernel_coarse[c] + add[c] - sub[c]);
+                }
+
+                uint32_t below = 0;
+                uint32_t c = 0;
+                while (below + kernel_coarse[c] <= rank) {
+                    below += kernel_coarse[c];
+                    c++;
+                }
+
+                // fine bins of the coarse bin are either moved from the last valid column or counted again
+                uint16_t* fine = &kernel_fine[(size_t)c * kFine];
+                const size_t offset = (size_t)c * kFine;
+                if (updated[c] < 0 || 2U * (i - (uint32_t)updated[c]) > diameter) {
+                    memset(fine, 0, kFine * sizeof(uint16_t));
+                    for (uint32_t j = i; j < i + diameter; j++) {
+                        const uint16_t* column = &column_fine[(size_t)j * kBins + offset];
+                        for (uint32_t f = 0; f < kFine; f++)
+                            fine[f] = (uint16_t)(fine[f] + column[f]);
+                    }
+                } else {
+                    for (uint32_t j = (uint32_t)updated[c] + 1U; j <= i; j++) {
+                        const uint16_t* add = &column_fine[(size_t)(j + 2U * radius) * kBins + offset];
+                        const uint16_t* sub = &column_fine[(size_t)(j - 1U) * kBins + offset];
+                        for (uint32_t f = 0; f < kFine; f++)
+                            fine[f] = (uint16_t)(fine[f] + add[f] - sub[f]);
+                    }
+                }
+                updated[c] = i;
+
+                uint32_t f = 0;
+                while (below + fine[f] <= rank) {
+                    below += fine[f];
+                    f++;
+                }
+                out_line[i] = (TPixel)(c * kFine + f);
+            }
+        }
+    }
+
+    *out_of_range = clamped;
+}
+
+} // namespace detail
+
+template <typename TPixel, uint32_t kBits>
+bool MedianFilter2D(const TPixel* in, TPixel* out, uint32_t width, uint32_t height, uint32_t radius,
+                    MedianBorder border, TPixel constant, uint32_t threads) {
+    static_assert(std::is_integral<TPixel>::value && std::is_unsigned<TPixel>::value && sizeof(TPixel) <= 2U,
+                  "TPixel must be uint8_t or uint16_t");
+    static_assert(kBits > 0U && kBits <= sizeof(TPixel) * 8U, "kBits must be in range 1..bits of TPixel");
+
+    if (width == 0U || height == 0U)
+        return true;
+    if (in == nullptr || out == nullptr || radius > detail::kMedFilter2DMaxRadius)
+        return false;
+
+    if (threads == 0U)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+
+    // every strip counts 2 * radius rows above it again, so keep strips much higher than the kernel
+    const uint32_t min_strip = std::max(detail::kMedFilter2DMinStrip, 4U * (2U * radius + 1U));
+    const uint32_t strips = std::max(1U, std::min(threads, height / min_strip));
+    const uint32_t strip = (height + strips - 1U) / strips;
+
+    const detail::MedianFilter2DFrame frame{width, height, radius, border};
+    std::vector<uint8_t> out_of_range(strips);
+
+    auto run_strip = [=, &frame, &out_of_range](uint32_t i) {
+        const uint32_t begin = i * strip;
+        bool clamped = false;
+        detail::MedianFilter2DStrip<TPixel, kBits>(in, out, frame, constant, begin, std::min(begin + strip, height),
+                                                   &clamped);
+        out_of_range[i] = clamped ? 1U : 0U;
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(strips - 1U);
+    uint32_t next = 1;
+    try {
+        for (; next < strips && next * strip < height; next++)
+            workers.emplace_back(run_strip, next);
+    } catch (const std::system_error&) {
+        // no more threads, strips from next are left for this thread; started workers are joined below
+    }
+    run_strip(0U);
+    for (; next < strips && next * strip < height; next++)
+        run_strip(next);
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    return std::find(out_of_range.begin(), out_of_range.end(), 1U) == out_of_range.end();
+}
+
+} // namespace common
+
+// MEDFILTER2D_INL
@@ -0,0 +1,116 @@
+// REMEDIAN_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for approximate running median of a very long window (kBase^kLevels values) in small memory
+///
+/// It is the remedian of Rousseeuw and Bassett made sliding: a cascade of kLevels Runmedian windows of kBase
+/// values. The first level is a running median of values, every kBase values its median goes to the next level,
+/// so a level has medians of the last kBase blocks of the level below. Value() is the median of the top level,
+/// it covers the last kWindow values, which are moved by blocks of kBase^(kLevels - 1) values.
+/// Memory is about kLevels * kBase * (sizeof(TRMValueType) + 1) bytes, Add() is kLevels Runmedian::Add() at most.
+///
+/// Rank error: when the top level is full after a complete block, the value has at least ((kBase + 1) / 2)^kLevels
+/// values of the window not greater and as many not less than it, so its rank in the window differs from the middle
+/// by RankErrorBound() * kWindow at most. It is the worst case of adversarial order, for random order the error
+/// is much less (see the benchmark).
+/// LockPolicy and ErrorPolicy are the same as for Runmedian.
+template <typename TRMValueType, const uint8_t kBase, const uint8_t kLevels, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class Remedian : private LockPolicy, private ErrorPolicy {
+  public:
+    Remedian() = default;
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(kBase >= 3U && kBase % 2U == 1U, "kBase must be odd, 3..255");
+    static_assert(kLevels > 0U, "kLevels must be at least 1");
+
+    /**
+     * @brief count of values covered by the full top level, kBase^kLevels
+     */
+    static constexpr uint64_t kWindow = [] {
+        uint64_t window = 1U;
+        for (uint8_t i = 0; i < kLevels; i++)
+            window *= kBase;
+        return window;
+    }();
+    static_assert(kWindow < 0x100000000ULL, "kBase^kLevels must be less than 2^32");
+
+    /**
+     * @brief the worst rank error as a fraction of kWindow, 0.5 - ((kBase + 1) / (2 * kBase))^kLevels
+     */
+    static constexpr double RankErrorBound();
+
+    /**
+     * @brief memory of the object in bytes
+     */
+    static constexpr size_t Footprint();
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief approximate running median value, the median of the top not empty level
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief Returns a count of values being used for calculating running median, kWindow at most.
+     */
+    uint32_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values.
+     *
+     * @param container another value for calculating running median.
+     */
+    void Add(TRMValueType container);
+
+    /**
+     * @brief Adds a number of values under one lock, optionally with running median after every value.
+     *
+     * @param data values for calculating running median.
+     * @param count count of values.
+     * @param medians_out if not nullptr, receives running median after every value (count items).
+     */
+    void AddBatch(const TRMValueType* data, size_t count, TRMValueType* medians_out = nullptr);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks every level and counts of values between levels
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    void Push(TRMValueType val);
+    TRMValueType Median() const;
+
+    Runmedian<TRMValueType, kBase, NoLock, IgnoreError> levels_[kLevels]{};
+    uint8_t pending_[kLevels]{}; // values added to a level after its last median went to the next level
+    uint32_t count_{};           // count of values, kWindow at most
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "remedian.inl"
+
+// REMEDIAN_END
@@ -0,0 +1,156 @@
+// REMEDIAN_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "remedian.hpp"
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+constexpr double Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::RankErrorBound() {
+    // the median of a level has (kBase + 1) / 2 not greater medians of the level below, and so on down to values
+    double fraction = 1.0;
+    for (uint8_t i = 0; i < kLevels; i++)
+        fraction *= (double)((kBase + 1U) / 2U) / (double)kBase;
+    return 0.5 - fraction;
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+constexpr size_t Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Footprint() {
+    return sizeof(Remedian);
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+void Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                        LockCb lock_cb,
+                                                                                        UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+void Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Push(TRMValueType val) {
+    if (count_ < kWindow) {
+        count_++;
+    }
+
+    // a median goes up when the level below has got a complete block of kBase values
+    for (uint8_t level = 0; level < kLevels; level++) {
+        levels_[level].Add(val);
+        if (level + 1U == kLevels)
+            break;
+
+        pending_[level]++;
+        if (pending_[level] < kBase)
+            break;
+
+        pending_[level] = 0;
+        val = levels_[level].Value();
+    }
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Median() const {
+    // levels are filled from the bottom, the top not empty one covers the most values
+    for (uint8_t level = kLevels; level > 0U; level--) {
+        if (!levels_[level - 1U].IsEmpty())
+            return levels_[level - 1U].Value();
+    }
+    return TRMValueType{};
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+TRMValueType Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Value() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = Median();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+uint32_t Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Size() const {
+    return count_;
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+bool Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return count_ == 0U;
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+void Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Add(TRMValueType val) {
+    CONTAINER_LOCK();
+    Push(val);
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+void Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::AddBatch(const TRMValueType* data, size_t count,
+                                                                               TRMValueType* medians_out) {
+    HANDLE_ERRORV(data != nullptr || count == 0U);
+
+    CONTAINER_LOCK();
+    if (medians_out != nullptr) {
+        for (size_t i = 0; i < count; i++) {
+            Push(data[i]);
+            medians_out[i] = Median();
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            Push(data[i]);
+        }
+    }
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+void Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    for (uint8_t level = 0; level < kLevels; level++) {
+        levels_[level].Clear();
+        pending_[level] = 0;
+    }
+    count_ = 0;
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kBase, uint8_t kLevels, typename LockPolicy, typename ErrorPolicy>
+bool Remedian<TRMValueType, kBase, kLevels, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (count_ > kWindow)
+        return false;
+
+    // count of values, which have got to a level, is known from the count of values
+    uint64_t block = 1U;
+    for (uint8_t level = 0; level < kLevels; level++) {
+        if (!levels_[level]._check_integrity() || pending_[level] >= kBase)
+            return false;
+        if (count_ < kWindow) {
+            const uint64_t added = count_ / block;
+            if (levels_[level].Size() != (added < kBase ? added : kBase))
+                return false;
+            if (level + 1U < kLevels && pending_[level] != added % kBase)
+                return false;
+        }
+        block *= kBase;
+    }
+
+    return true;
+}
+
+} // namespace common
+
+// REMEDIAN_INL
@@ -0,0 +1,81 @@
+// RMCHECKPOINT_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+constexpr uint32_t kCheckpointMagic = 0x4E444D52U; // "RMDN" at little endian memory
+constexpr uint16_t kCheckpointVersion = 1U;
+
+/// @brief Header of a checkpoint, it is followed by memory images of engines.
+///
+/// A checkpoint is a copy of engine objects as they are, so it is loaded with one copy and may be used in place
+/// (memory mapped file). The header describes the layout, so a checkpoint of another engine type, window,
+/// compiler or byte order is rejected instead of being misread.
+struct CheckpointHeader {
+    uint32_t magic;        // kCheckpointMagic, a checkpoint of other byte order has other value
+    uint16_t version;      // kCheckpointVersion
+    uint16_t header_size;  // offset of the first engine, sizeof(CheckpointHeader)
+    uint32_t object_size;  // sizeof of an engine
+    uint32_t object_align; // alignof of an engine
+    uint32_t value_size;   // sizeof of a value
+    uint8_t value_kind;    // 0 for unsigned integral values, 1 for signed integral ones, 2 for floating point ones
+    uint8_t reserved8[3];
+    uint32_t window;  // window size of an engine
+    uint64_t count;   // count of engines
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(CheckpointHeader) == 64U, "header keeps engines aligned to a cache line");
+
+/**
+ * @brief Returns size of a checkpoint of count engines in bytes.
+ */
+template <typename TEngine> constexpr size_t CheckpointSize(size_t count);
+
+/**
+ * @brief Saves engines to a checkpoint. Engine must have state without callbacks (NoLock and IgnoreError policies).
+ *
+ * @param engines engines to save.
+ * @param count count of engines.
+ * @param buffer checkpoint, CheckpointSize<TEngine>(count) bytes at least.
+ * @param size size of buffer in bytes.
+ * @return size of the checkpoint in bytes, 0 for wrong parameters.
+ */
+template <typename TEngine> size_t SaveCheckpoint(const TEngine* engines, size_t count, void* buffer, size_t size);
+
+/**
+ * @brief Restores engines from a checkpoint of the same engine type.
+ *
+ * @param buffer checkpoint.
+ * @param size size of buffer in bytes.
+ * @param engines engines to restore.
+ * @param count count of engines, must be the same as at the checkpoint.
+ * @param verify checks every engine with _check_integrity(), it is CPU bound. Without it engines are checked by
+ * _check_bounds() only, so a broken checkpoint never makes an engine write out of its window.
+ * @return false for wrong parameters, not matching or broken checkpoint.
+ */
+template <typename TEngine>
+bool LoadCheckpoint(const void* buffer, size_t size, TEngine* engines, size_t count, bool verify = false);
+
+/**
+ * @brief Returns engines of a checkpoint to be used in place, without copying, for example at a memory mapped file.
+ *
+ * @param buffer checkpoint, aligned for TEngine (a mapped file is aligned to a page).
+ * @param size size of buffer in bytes.
+ * @param count receives count of engines.
+ * @param verify checks every engine with _check_integrity() instead of _check_bounds(), as LoadCheckpoint().
+ * @return the first engine, nullptr for not matching, broken checkpoint or not aligned buffer.
+ */
+template <typename TEngine> TEngine* MapCheckpoint(void* buffer, size_t size, size_t* count, bool verify = false);
+
+} // namespace common
+
+// Here comes the implementation.
+#include "rmcheckpoint.inl"
+
+// RMCHECKPOINT_END
@@ -0,0 +1,116 @@
+// RMCHECKPOINT_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rmcheckpoint.hpp"
+
+#include <cstring>
+
+namespace common {
+
+namespace detail {
+
+template <typename TEngine> constexpr void CheckpointRequirements() {
+    static_assert(std::is_trivially_copyable<TEngine>::value, "engine must be trivially copyable");
+    static_assert(TEngine::kPlainState, "engine state must be plain data, without callbacks");
+    static_assert(alignof(TEngine) <= sizeof(CheckpointHeader), "engine is aligned more than a header");
+}
+
+template <typename TEngine> CheckpointHeader MakeCheckpointHeader(size_t count) {
+    using ValueType = typename TEngine::ValueType;
+
+    CheckpointHeader header{};
+    header.magic = kCheckpointMagic;
+    header.version = kCheckpointVersion;
+    header.header_size = (uint16_t)sizeof(CheckpointHeader);
+    header.object_size = (uint32_t)sizeof(TEngine);
+    header.object_align = (uint32_t)alignof(TEngine);
+    header.value_size = (uint32_t)sizeof(ValueType);
+    header.value_kind = std::is_floating_point<ValueType>::value ? 2U : (std::is_signed<ValueType>::value ? 1U : 0U);
+    header.window = (uint32_t)TEngine::kWindow;
+    header.count = count;
+    return header;
+}
+
+// Returns count of engines at the checkpoint or -1 if it is not a checkpoint of TEngine
+template <typename TEngine> int64_t CheckpointCount(const void* buffer, size_t size) {
+    if (buffer == nullptr || size < sizeof(CheckpointHeader))
+        return -1;
+
+    CheckpointHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    const CheckpointHeader expected = MakeCheckpointHeader<TEngine>(header.count);
+    if (memcmp(&header, &expected, sizeof(header)) != 0)
+        return -1;
+    if (header.count > (size - sizeof(CheckpointHeader)) / sizeof(TEngine))
+        return -1;
+
+    return (int64_t)header.count;
+}
+
+// Checks restored engines: bounds of every engine always, full integrity on demand
+template <typename TEngine> bool CheckpointEngines(TEngine* engines, size_t count, bool verify) {
+    for (size_t i = 0; i < count; i++) {
+        if (!(verify ? engines[i]._check_integrity() : engines[i]._check_bounds()))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace detail
+
+template <typename TEngine> constexpr size_t CheckpointSize(size_t count) {
+    return sizeof(CheckpointHeader) + count * sizeof(TEngine);
+}
+
+template <typename TEngine> size_t SaveCheckpoint(const TEngine* engines, size_t count, void* buffer, size_t size) {
+    detail::CheckpointRequirements<TEngine>();
+
+    if (buffer == nullptr || (engines == nullptr && count > 0U) ||
+        count > (SIZE_MAX - sizeof(CheckpointHeader)) / sizeof(TEngine) || size < CheckpointSize<TEngine>(count))
+        return 0U;
+
+    const CheckpointHeader header = detail::MakeCheckpointHeader<TEngine>(count);
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    memcpy(out, &header, sizeof(header));
+    if (count > 0U) {
+        memcpy(out + sizeof(header), engines, count * sizeof(TEngine));
+    }
+
+    return CheckpointSize<TEngine>(count);
+}
+
+template <typename TEngine>
+bool LoadCheckpoint(const void* buffer, size_t size, TEngine* engines, size_t count, bool verify) {
+    detail::CheckpointRequirements<TEngine>();
+
+    if ((engines == nullptr && count > 0U) || detail::CheckpointCount<TEngine>(buffer, size) != (int64_t)count)
+        return false;
+
+    if (count > 0U) {
+        memcpy((void*)engines, static_cast<const uint8_t*>(buffer) + sizeof(CheckpointHeader),
+               count * sizeof(TEngine));
+    }
+
+    return detail::CheckpointEngines(engines, count, verify);
+}
+
+template <typename TEngine> TEngine* MapCheckpoint(void* buffer, size_t size, size_t* count, bool verify) {
+    detail::CheckpointRequirements<TEngine>();
+
+    const int64_t engines = detail::CheckpointCount<TEngine>(buffer, size);
+    if (engines < 0 || count == nullptr || (uintptr_t)buffer % alignof(TEngine) != 0U)
+        return nullptr;
+
+    TEngine* mapped = reinterpret_cast<TEngine*>(static_cast<uint8_t*>(buffer) + sizeof(CheckpointHeader));
+    if (!detail::CheckpointEngines(mapped, (size_t)engines, verify))
+        return nullptr;
+
+    *count = (size_t)engines;
+    return mapped;
+}
+
+} // namespace common
+
+// RMCHECKPOINT_INL
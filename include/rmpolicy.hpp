@@ -0,0 +1,200 @@
+// RMPOLICY_HPP
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdbool.h>
+
+namespace common {
+
+typedef void (*LockCb)(void);
+typedef void (*UnlockCb)(void);
+typedef void (*ErrorCb)(void);
+
+// Containers inherit lock and error policies, so the macros resolve at compile time and
+// inline away for NoLock and IgnoreError.
+
+#define CONTAINER_LOCK()                                                                                               \
+    do {                                                                                                               \
+        this->Lock();                                                                                                  \
+    } while (0)
+
+#define CONTAINER_UNLOCK()                                                                                             \
+    do {                                                                                                               \
+        this->Unlock();                                                                                                \
+    } while (0)
+
+#define HANDLE_ERROR(condition, retval)                                                                                \
+    do {                                                                                                               \
+        if (this->OnError(!(condition))) {                                                                             \
+            return retval;                                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+#define HANDLE_ERRORV(condition)                                                                                       \
+    do {                                                                                                               \
+        if (this->OnError(!(condition))) {                                                                             \
+            return;                                                                                                    \
+        }                                                                                                              \
+    } while (0)
+
+// Containers with a stats policy also time the hold of the lock.
+
+#define CONTAINER_LOCK_STATS()                                                                                         \
+    do {                                                                                                               \
+        this->Lock();                                                                                                  \
+        this->StatsLocked();                                                                                           \
+    } while (0)
+
+#define CONTAINER_UNLOCK_STATS()                                                                                       \
+    do {                                                                                                               \
+        this->StatsUnlocking();                                                                                        \
+        this->Unlock();                                                                                                \
+    } while (0)
+
+/// @brief Lock policy without any locking, for single thread usage.
+class NoLock {
+  public:
+    static constexpr bool kCallbacks = false;
+
+    void Lock() const;
+    void Unlock() const;
+};
+
+/// @brief Lock policy with user's lock and unlock functions, does nothing until they are registered.
+class CallbackLock {
+  public:
+    static constexpr bool kCallbacks = true;
+
+    void RegisterLockCallbacks(LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+    void Lock() const;
+    void Unlock() const;
+
+  private:
+    LockCb lock_cb_{nullptr};
+    UnlockCb unlock_cb_{nullptr};
+};
+
+/// @brief Lock policy with own std::mutex.
+class StdMutex {
+  public:
+    static constexpr bool kCallbacks = false;
+
+    void Lock() const;
+    void Unlock() const;
+
+  private:
+    mutable std::mutex mutex_;
+};
+
+/// @brief Lock policy with own spin lock, for short critical regions.
+class SpinLock {
+  public:
+    static constexpr bool kCallbacks = false;
+
+    void Lock() const;
+    void Unlock() const;
+
+  private:
+    mutable std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+/// @brief Error policy, which ignores all errors.
+class IgnoreError {
+  public:
+    static constexpr bool kCallbacks = false;
+
+    /**
+     * @brief Returns true if the caller must stop because of error.
+     *
+     * @param failed error condition.
+     */
+    bool OnError(bool failed) const;
+};
+
+/// @brief Error policy with user's error function, errors are ignored until it is registered.
+class CallbackError {
+  public:
+    static constexpr bool kCallbacks = true;
+
+    void RegisterErrorCallback(ErrorCb error_cb = nullptr);
+
+    /**
+     * @brief Calls error function and returns true if there is an error and the function is registered.
+     *
+     * @param failed error condition.
+     */
+    bool OnError(bool failed) const;
+
+  private:
+    ErrorCb error_cb_{nullptr};
+};
+
+/// @brief Counters of a container's hot path, a snapshot of a stats policy.
+struct StatsCounters {
+    uint64_t adds;           // values added
+    uint64_t compared;       // values compared with new ones to find their positions
+    uint64_t shifted;        // values moved at the sorted array to make place for new ones
+    uint64_t locks;          // count of lock holds
+    uint64_t lock_ticks;     // time under the lock, see StatsTicks()
+    uint64_t lock_ticks_max; // the longest hold of the lock
+};
+
+/**
+ * @brief Time for stats: time stamp counter (CPU cycles) on x86, nanoseconds of std::chrono::steady_clock otherwise.
+ */
+inline uint64_t StatsTicks();
+
+/// @brief Stats policy without any counting, it has no storage and no code.
+class NoStats {
+  public:
+    static constexpr bool kEnabled = false;
+
+    void StatsAdd(uint32_t compared, uint32_t shifted) const;
+    void StatsLocked() const;
+    void StatsUnlocking() const;
+};
+
+/// @brief Stats policy with own counters of the container, they are changed under the container's lock.
+class InstanceStats {
+  public:
+    static constexpr bool kEnabled = true;
+
+    void StatsAdd(uint32_t compared, uint32_t shifted) const;
+    void StatsLocked() const;
+    void StatsUnlocking() const;
+    StatsCounters StatsSnapshot() const;
+
+  private:
+    mutable StatsCounters counters_{};
+    mutable uint64_t locked_at_{};
+};
+
+/// @brief Stats policy with counters of the calling thread, they are shared by all containers with this policy
+/// at the thread, so they are changed without any lock and a snapshot has counters of the calling thread only.
+class ThreadStats {
+  public:
+    static constexpr bool kEnabled = true;
+
+    void StatsAdd(uint32_t compared, uint32_t shifted) const;
+    void StatsLocked() const;
+    void StatsUnlocking() const;
+    StatsCounters StatsSnapshot() const;
+
+    /**
+     * @brief Sets counters of the calling thread to zero.
+     */
+    static void Reset();
+
+  private:
+    static StatsCounters& Counters();
+    static uint64_t& LockedAt();
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "rmpolicy.inl"
+
+// RMPOLICY_END
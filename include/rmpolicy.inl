@@ -0,0 +1,151 @@
+// RMPOLICY_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rmpolicy.hpp"
+
+#include <chrono>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+namespace common {
+
+inline void NoLock::Lock() const {}
+
+inline void NoLock::Unlock() const {}
+
+inline void CallbackLock::RegisterLockCallbacks(LockCb lock_cb, UnlockCb unlock_cb) {
+    lock_cb_ = lock_cb;
+    unlock_cb_ = unlock_cb;
+}
+
+inline void CallbackLock::Lock() const {
+    if (nullptr != lock_cb_) {
+        lock_cb_();
+    }
+}
+
+inline void CallbackLock::Unlock() const {
+    if (nullptr != unlock_cb_) {
+        unlock_cb_();
+    }
+}
+
+inline void StdMutex::Lock() const {
+    mutex_.lock();
+}
+
+inline void StdMutex::Unlock() const {
+    mutex_.unlock();
+}
+
+inline void SpinLock::Lock() const {
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+    }
+}
+
+inline void SpinLock::Unlock() const {
+    flag_.clear(std::memory_order_release);
+}
+
+inline bool IgnoreError::OnError(bool) const {
+    return false;
+}
+
+inline void CallbackError::RegisterErrorCallback(ErrorCb error_cb) {
+    error_cb_ = error_cb;
+}
+
+inline bool CallbackError::OnError(bool failed) const {
+    if (failed && nullptr != error_cb_) {
+        error_cb_();
+        return true;
+    }
+    return false;
+}
+
+inline uint64_t StatsTicks() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) ||                                                   \
+    ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+    return (uint64_t)__rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+inline void NoStats::StatsAdd(uint32_t, uint32_t) const {}
+
+inline void NoStats::StatsLocked() const {}
+
+inline void NoStats::StatsUnlocking() const {}
+
+inline void InstanceStats::StatsAdd(uint32_t compared, uint32_t shifted) const {
+    counters_.adds++;
+    counters_.compared += compared;
+    counters_.shifted += shifted;
+}
+
+inline void InstanceStats::StatsLocked() const {
+    locked_at_ = StatsTicks();
+}
+
+inline void InstanceStats::StatsUnlocking() const {
+    const uint64_t ticks = StatsTicks() - locked_at_;
+    counters_.locks++;
+    counters_.lock_ticks += ticks;
+    if (ticks > counters_.lock_ticks_max) {
+        counters_.lock_ticks_max = ticks;
+    }
+}
+
+inline StatsCounters InstanceStats::StatsSnapshot() const {
+    return counters_;
+}
+
+inline StatsCounters& ThreadStats::Counters() {
+    static thread_local StatsCounters counters{};
+    return counters;
+}
+
+inline uint64_t& ThreadStats::LockedAt() {
+    static thread_local uint64_t locked_at = 0;
+    return locked_at;
+}
+
+inline void ThreadStats::StatsAdd(uint32_t compared, uint32_t shifted) const {
+    StatsCounters& counters = Counters();
+    counters.adds++;
+    counters.compared += compared;
+    counters.shifted += shifted;
+}
+
+inline void ThreadStats::StatsLocked() const {
+    LockedAt() = StatsTicks();
+}
+
+inline void ThreadStats::StatsUnlocking() const {
+    StatsCounters& counters = Counters();
+    const uint64_t ticks = StatsTicks() - LockedAt();
+    counters.locks++;
+    counters.lock_ticks += ticks;
+    if (ticks > counters.lock_ticks_max) {
+        counters.lock_ticks_max = ticks;
+    }
+}
+
+inline StatsCounters ThreadStats::StatsSnapshot() const {
+    return Counters();
+}
+
+inline void ThreadStats::Reset() {
+    Counters() = StatsCounters{};
+}
+
+} // namespace common
+
+// RMPOLICY_INL
@@ -0,0 +1,71 @@
+// RMSIMD_HPP
+#pragma once
+
+#include <cstdint>
+#include <stdbool.h>
+
+// Vector kernels are used when the target has them, define RUNMEDIAN_NO_SIMD to use scalar code only.
+#if !defined(RUNMEDIAN_NO_SIMD)
+#if defined(__AVX2__)
+#define RUNMEDIAN_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RUNMEDIAN_SIMD_SSE2 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define RUNMEDIAN_SIMD_NEON 1
+#endif
+#endif
+
+namespace common {
+namespace simd {
+
+/**
+ * @brief Returns count of values at sorted array, which are less or equal to val.
+ * It is the same as std::upper_bound offset.
+ *
+ * @param values sorted from less to greater values.
+ * @param count count of values.
+ * @param val value to compare with.
+ */
+template <typename T> uint32_t CountNotGreater(const T* values, uint32_t count, T val);
+
+/**
+ * @brief Returns index of the first value equal to val or count if there is no such value.
+ *
+ * @param values array of values.
+ * @param count count of values.
+ * @param val value to find.
+ */
+template <typename T> uint32_t FindFirst(const T* values, uint32_t count, T val);
+
+// Vector versions for the most used types, scalar templates above are used for the rest.
+inline uint32_t CountNotGreater(const uint8_t* values, uint32_t count, uint8_t val);
+inline uint32_t CountNotGreater(const uint16_t* values, uint32_t count, uint16_t val);
+inline uint32_t CountNotGreater(const int32_t* values, uint32_t count, int32_t val);
+inline uint32_t CountNotGreater(const float* values, uint32_t count, float val);
+
+inline uint32_t FindFirst(const uint8_t* values, uint32_t count, uint8_t val);
+inline uint32_t FindFirst(const uint16_t* values, uint32_t count, uint16_t val);
+inline uint32_t FindFirst(const int32_t* values, uint32_t count, int32_t val);
+inline uint32_t FindFirst(const float* values, uint32_t count, float val);
+
+/**
+ * @brief Adds delta to every value in range from..from+range-1, other values stay the same.
+ * Values wrap around as uint8_t, so delta 0xFF is the same as -1.
+ *
+ * @param values array of values.
+ * @param count count of values.
+ * @param from the first value to change.
+ * @param range count of values to change, starting with from.
+ * @param delta value to add.
+ */
+inline void AddInRange(uint8_t* values, uint32_t count, uint8_t from, uint8_t range, uint8_t delta);
+
+} // namespace simd
+} // namespace common
+
+// Here comes the implementation.
+#include "rmsimd.inl"
+
+// RMSIMD_END
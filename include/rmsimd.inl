@@ -0,0 +1,345 @@
+// RMSIMD_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rmsimd.hpp"
+
+#include <algorithm>
+
+#if defined(RUNMEDIAN_SIMD_SSE2) || defined(RUNMEDIAN_SIMD_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(RUNMEDIAN_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace common {
+namespace simd {
+
+namespace detail {
+
+inline uint32_t PopCount32(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_popcount(mask);
+#else
+    // popcnt instruction is not a part of SSE2, so count bits in a portable way
+    mask = mask - ((mask >> 1) & 0x55555555U);
+    mask = (mask & 0x33333333U) + ((mask >> 2) & 0x33333333U);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0FU) * 0x01010101U) >> 24;
+#endif
+}
+
+// mask must not be zero
+inline uint32_t Ctz32(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
+#else
+    uint32_t index = 0;
+    while (!(mask & 1U)) {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+} // namespace detail
+
+template <typename T> uint32_t CountNotGreater(const T* values, uint32_t count, T val) {
+    return (uint32_t)(std::upper_bound(values, values + count, val) - values);
+}
+
+template <typename T> uint32_t FindFirst(const T* values, uint32_t count, T val) {
+    return (uint32_t)(std::find(values, values + count, val) - values);
+}
+
+// Vector versions look through the sorted array by blocks and stop at the first block with a greater value,
+// so the cost is proportional to the rank of the value. Tail is handled by the scalar code.
+
+inline uint32_t CountNotGreater(const uint8_t* values, uint32_t count, uint8_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v32 = _mm256_set1_epi8((char)val);
+    for (; i + 32U <= count; i += 32U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t le = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(x, v32), v32));
+        if (le != 0xFFFFFFFFU)
+            return i + detail::PopCount32(le);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i v16 = _mm_set1_epi8((char)val);
+    for (; i + 16U <= count; i += 16U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const uint32_t le = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(x, v16), v16));
+        if (le != 0xFFFFU)
+            return i + detail::PopCount32(le);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const uint8x16_t v16 = vdupq_n_u8(val);
+    for (; i + 16U <= count; i += 16U) {
+        const uint32_t le = vaddvq_u8(vshrq_n_u8(vcleq_u8(vld1q_u8(values + i), v16), 7));
+        if (le != 16U)
+            return i + le;
+    }
+#endif
+    return i + CountNotGreater<uint8_t>(values + i, count - i, val);
+}
+
+inline uint32_t CountNotGreater(const uint16_t* values, uint32_t count, uint16_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v16 = _mm256_set1_epi16((short)val);
+    for (; i + 16U <= count; i += 16U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t le = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_max_epu16(x, v16), v16));
+        if (le != 0xFFFFFFFFU)
+            return i + (detail::PopCount32(le) >> 1);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    // SSE2 has no unsigned 16-bit compare, so values are biased to signed range
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    const __m128i v8 = _mm_xor_si128(_mm_set1_epi16((short)val), bias);
+    for (; i + 8U <= count; i += 8U) {
+        const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + i)), bias);
+        const uint32_t gt = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi16(x, v8));
+        if (gt != 0U)
+            return i + 8U - (detail::PopCount32(gt) >> 1);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const uint16x8_t v8 = vdupq_n_u16(val);
+    for (; i + 8U <= count; i += 8U) {
+        const uint32_t le = vaddvq_u16(vshrq_n_u16(vcleq_u16(vld1q_u16(values + i), v8), 15));
+        if (le != 8U)
+            return i + le;
+    }
+#endif
+    return i + CountNotGreater<uint16_t>(values + i, count - i, val);
+}
+
+inline uint32_t CountNotGreater(const int32_t* values, uint32_t count, int32_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v8 = _mm256_set1_epi32(val);
+    for (; i + 8U <= count; i += 8U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t gt = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, v8)));
+        if (gt != 0U)
+            return i + 8U - detail::PopCount32(gt);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i v4 = _mm_set1_epi32(val);
+    for (; i + 4U <= count; i += 4U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const uint32_t gt = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, v4)));
+        if (gt != 0U)
+            return i + 4U - detail::PopCount32(gt);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const int32x4_t v4 = vdupq_n_s32(val);
+    for (; i + 4U <= count; i += 4U) {
+        const uint32_t le = vaddvq_u32(vshrq_n_u32(vcleq_s32(vld1q_s32(values + i), v4), 31));
+        if (le != 4U)
+            return i + le;
+    }
+#endif
+    return i + CountNotGreater<int32_t>(values + i, count - i, val);
+}
+
+inline uint32_t CountNotGreater(const float* values, uint32_t count, float val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256 v8 = _mm256_set1_ps(val);
+    for (; i + 8U <= count; i += 8U) {
+        const uint32_t le = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), v8, _CMP_LE_OQ));
+        if (le != 0xFFU)
+            return i + detail::PopCount32(le);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128 v4 = _mm_set1_ps(val);
+    for (; i + 4U <= count; i += 4U) {
+        const uint32_t le = (uint32_t)_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(values + i), v4));
+        if (le != 0xFU)
+            return i + detail::PopCount32(le);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const float32x4_t v4 = vdupq_n_f32(val);
+    for (; i + 4U <= count; i += 4U) {
+        const uint32_t le = vaddvq_u32(vshrq_n_u32(vcleq_f32(vld1q_f32(values + i), v4), 31));
+        if (le != 4U)
+            return i + le;
+    }
+#endif
+    return i + CountNotGreater<float>(values + i, count - i, val);
+}
+
+inline uint32_t FindFirst(const uint8_t* values, uint32_t count, uint8_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v32 = _mm256_set1_epi8((char)val);
+    for (; i + 32U <= count; i += 32U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, v32));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i v16 = _mm_set1_epi8((char)val);
+    for (; i + 16U <= count; i += 16U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, v16));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const uint8x16_t v16 = vdupq_n_u8(val);
+    for (; i + 16U <= count; i += 16U) {
+        if (vmaxvq_u8(vceqq_u8(vld1q_u8(values + i), v16)) != 0U)
+            break; // the scalar code below finds exact position inside the block
+    }
+#endif
+    return i + FindFirst<uint8_t>(values + i, count - i, val);
+}
+
+inline uint32_t FindFirst(const uint16_t* values, uint32_t count, uint16_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v16 = _mm256_set1_epi16((short)val);
+    for (; i + 16U <= count; i += 16U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(x, v16));
+        if (eq != 0U)
+            return i + (detail::Ctz32(eq) >> 1);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i v8 = _mm_set1_epi16((short)val);
+    for (; i + 8U <= count; i += 8U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(x, v8));
+        if (eq != 0U)
+            return i + (detail::Ctz32(eq) >> 1);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const uint16x8_t v8 = vdupq_n_u16(val);
+    for (; i + 8U <= count; i += 8U) {
+        if (vmaxvq_u16(vceqq_u16(vld1q_u16(values + i), v8)) != 0U)
+            break;
+    }
+#endif
+    return i + FindFirst<uint16_t>(values + i, count - i, val);
+}
+
+inline uint32_t FindFirst(const int32_t* values, uint32_t count, int32_t val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i v8 = _mm256_set1_epi32(val);
+    for (; i + 8U <= count; i += 8U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v8)));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i v4 = _mm_set1_epi32(val);
+    for (; i + 4U <= count; i += 4U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const uint32_t eq = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v4)));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const int32x4_t v4 = vdupq_n_s32(val);
+    for (; i + 4U <= count; i += 4U) {
+        if (vmaxvq_u32(vceqq_s32(vld1q_s32(values + i), v4)) != 0U)
+            break;
+    }
+#endif
+    return i + FindFirst<int32_t>(values + i, count - i, val);
+}
+
+inline uint32_t FindFirst(const float* values, uint32_t count, float val) {
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256 v8 = _mm256_set1_ps(val);
+    for (; i + 8U <= count; i += 8U) {
+        const uint32_t eq = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), v8, _CMP_EQ_OQ));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128 v4 = _mm_set1_ps(val);
+    for (; i + 4U <= count; i += 4U) {
+        const uint32_t eq = (uint32_t)_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), v4));
+        if (eq != 0U)
+            return i + detail::Ctz32(eq);
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const float32x4_t v4 = vdupq_n_f32(val);
+    for (; i + 4U <= count; i += 4U) {
+        if (vmaxvq_u32(vceqq_f32(vld1q_f32(values + i), v4)) != 0U)
+            break;
+    }
+#endif
+    return i + FindFirst<float>(values + i, count - i, val);
+}
+
+inline void AddInRange(uint8_t* values, uint32_t count, uint8_t from, uint8_t range, uint8_t delta) {
+    if (range == 0U)
+        return;
+
+    // value is in range if (value - from) wrapped as uint8_t is not greater than range - 1
+    uint32_t i = 0;
+#if defined(RUNMEDIAN_SIMD_AVX2)
+    const __m256i from32 = _mm256_set1_epi8((char)from);
+    const __m256i last32 = _mm256_set1_epi8((char)(range - 1U));
+    const __m256i delta32 = _mm256_set1_epi8((char)delta);
+    for (; i + 32U <= count; i += 32U) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        const __m256i offset = _mm256_sub_epi8(x, from32);
+        const __m256i in = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, last32), offset);
+        _mm256_storeu_si256((__m256i*)(values + i), _mm256_add_epi8(x, _mm256_and_si256(in, delta32)));
+    }
+#endif
+#if defined(RUNMEDIAN_SIMD_SSE2)
+    const __m128i from16 = _mm_set1_epi8((char)from);
+    const __m128i last16 = _mm_set1_epi8((char)(range - 1U));
+    const __m128i delta16 = _mm_set1_epi8((char)delta);
+    for (; i + 16U <= count; i += 16U) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        const __m128i offset = _mm_sub_epi8(x, from16);
+        const __m128i in = _mm_cmpeq_epi8(_mm_min_epu8(offset, last16), offset);
+        _mm_storeu_si128((__m128i*)(values + i), _mm_add_epi8(x, _mm_and_si128(in, delta16)));
+    }
+#elif defined(RUNMEDIAN_SIMD_NEON)
+    const uint8x16_t from16 = vdupq_n_u8(from);
+    const uint8x16_t range16 = vdupq_n_u8(range);
+    const uint8x16_t delta16 = vdupq_n_u8(delta);
+    for (; i + 16U <= count; i += 16U) {
+        const uint8x16_t x = vld1q_u8(values + i);
+        const uint8x16_t in = vcltq_u8(vsubq_u8(x, from16), range16);
+        vst1q_u8(values + i, vaddq_u8(x, vandq_u8(in, delta16)));
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] = (uint8_t)(values[i] + (((uint8_t)(values[i] - from) < range) ? delta : 0U));
+    }
+}
+
+} // namespace simd
+} // namespace common
+
+// RMSIMD_INL
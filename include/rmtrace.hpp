@@ -0,0 +1,113 @@
+// RMTRACE_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdbool.h>
+#include <vector>
+
+namespace common {
+
+constexpr size_t kTraceBlock = 1U << 20; // size of input reads and output writes, bytes
+constexpr size_t kTraceBatch = 4096;     // values per call of a sink
+
+/// @brief Counters of a trace run, filled by the decoders and the writer
+struct TraceStats {
+    uint64_t bytes_in = 0;
+    uint64_t values = 0;
+    uint64_t medians = 0;
+    uint64_t bytes_out = 0;
+    uint64_t skipped = 0; // text lines without a value
+};
+
+/**
+ * @brief Reads a value of little-endian layout, it is a plain load on little-endian hosts.
+ */
+template <typename T> T LoadLe(const unsigned char* bytes);
+
+/**
+ * @brief Writes a value in little-endian layout, it is a plain store on little-endian hosts.
+ */
+template <typename T> void StoreLe(T val, unsigned char* bytes);
+
+/**
+ * @brief Returns true if values in memory have little-endian layout, so a mapped trace is used as it is.
+ */
+inline bool IsLittleEndianHost();
+
+/**
+ * @brief Parses the number of a text field, which ends at a separator (',', ';' or tab) or at end.
+ *
+ * Spaces and one plus sign before the number and spaces or '\r' after it are allowed, anything else fails,
+ * so 1.9 or 1e3 is not a value of an integral type and a number out of the range of the type is not one either.
+ *
+ * @param pos the first character of the field.
+ * @param end end of the line.
+ * @param val receives the number.
+ * @return false if the field is not a number of type T.
+ */
+template <typename T> bool ParseTraceField(const char* pos, const char* end, T& val);
+
+/**
+ * @brief Takes the value of a column from whole records of raw little-endian values.
+ *
+ * @param data records.
+ * @param size size of data in bytes.
+ * @param column column of the value, from 0.
+ * @param columns values per record.
+ * @param sink receives values by bool Push(const T* values, size_t count), false stops decoding.
+ * @param ok receives false if the sink stopped.
+ * @return count of consumed bytes, whole records only.
+ */
+template <typename T, typename TSink>
+size_t DecodeBinaryTrace(const unsigned char* data, size_t size, size_t column, size_t columns, TSink& sink,
+                         bool& ok);
+
+/**
+ * @brief Takes the value of a column from whole text lines, lines without a value there are counted as skipped.
+ *
+ * @param data lines.
+ * @param size size of data in bytes.
+ * @param last there is no more input, a line without a new line at the end is taken too.
+ * @param column column of the value, from 0.
+ * @param sink receives values by bool Push(const T* values, size_t count), false stops decoding.
+ * @param stats receives count of skipped lines.
+ * @param ok receives false if the sink stopped.
+ * @return count of consumed bytes, whole lines only.
+ */
+template <typename T, typename TSink>
+size_t DecodeTextTrace(const char* data, size_t size, bool last, size_t column, TSink& sink, TraceStats& stats,
+                       bool& ok);
+
+/// @brief Output of medians through a buffer of kTraceBlock bytes, so the file gets big writes only.
+///
+/// Medians are raw little-endian values of type T or text, one number per line.
+template <typename T> class TraceWriter {
+  public:
+    TraceWriter(FILE* file, bool text, TraceStats& stats);
+
+    /**
+     * @brief Appends medians, writes the buffer when it is full; returns false for a write error.
+     */
+    bool Put(const T* medians, size_t count);
+
+    /**
+     * @brief Writes the buffer; returns false for a write error.
+     */
+    bool Flush();
+
+  private:
+    FILE* file_;
+    bool text_;
+    TraceStats& stats_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "rmtrace.inl"
+
+// RMTRACE_END
@@ -0,0 +1,168 @@
+// RMTRACE_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rmtrace.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+
+namespace common {
+
+namespace detail {
+
+template <typename T>
+using TraceBits = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+
+inline bool IsTraceSeparator(char c) {
+    return c == ',' || c == ';' || c == '\t';
+}
+
+} // namespace detail
+
+template <typename T> T LoadLe(const unsigned char* bytes) {
+    using TBits = detail::TraceBits<T>;
+    TBits bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bits |= (TBits)((TBits)bytes[i] << (8U * i));
+    }
+    T val;
+    std::memcpy(&val, &bits, sizeof(T));
+    return val;
+}
+
+template <typename T> void StoreLe(T val, unsigned char* bytes) {
+    using TBits = detail::TraceBits<T>;
+    TBits bits;
+    std::memcpy(&bits, &val, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = (unsigned char)(bits >> (8U * i));
+    }
+}
+
+inline bool IsLittleEndianHost() {
+    const uint16_t probe = 1U;
+    unsigned char bytes[sizeof(probe)];
+    std::memcpy(bytes, &probe, sizeof(probe));
+    return bytes[0] == 1U;
+}
+
+template <typename T> bool ParseTraceField(const char* pos, const char* end, T& val) {
+    while (pos < end && *pos == ' ') {
+        ++pos;
+    }
+    if (pos < end && *pos == '+') {
+        ++pos;
+    }
+    const auto [ptr, ec] = std::from_chars(pos, end, val);
+    if (ec != std::errc()) {
+        return false;
+    }
+    // the whole field is the number
+    const char* rest = ptr;
+    while (rest < end && (*rest == ' ' || *rest == '\r')) {
+        ++rest;
+    }
+    return rest == end || detail::IsTraceSeparator(*rest);
+}
+
+template <typename T, typename TSink>
+size_t DecodeBinaryTrace(const unsigned char* data, size_t size, size_t column, size_t columns, TSink& sink,
+                         bool& ok) {
+    const size_t record = sizeof(T) * columns;
+    const size_t records = size / record;
+    const unsigned char* pos = data + sizeof(T) * column;
+    T values[kTraceBatch];
+    for (size_t done = 0; done < records && ok;) {
+        const size_t count = (std::min)(records - done, kTraceBatch);
+        for (size_t i = 0; i < count; ++i, pos += record) {
+            values[i] = LoadLe<T>(pos);
+        }
+        ok = sink.Push(values, count);
+        done += count;
+    }
+    return records * record;
+}
+
+template <typename T, typename TSink>
+size_t DecodeTextTrace(const char* data, size_t size, bool last, size_t column, TSink& sink, TraceStats& stats,
+                       bool& ok) {
+    T values[kTraceBatch];
+    size_t count = 0;
+    const char* pos = data;
+    const char* const end = data + size;
+    while (pos < end && ok) {
+        const char* eol = (const char*)std::memchr(pos, '\n', (size_t)(end - pos));
+        if (eol == nullptr) {
+            if (!last) {
+                break;
+            }
+            eol = end;
+        }
+        // skip to the field
+        const char* field = pos;
+        for (size_t skipped = 0; skipped < column && field < eol; ++field) {
+            if (detail::IsTraceSeparator(*field)) {
+                ++skipped;
+                if (skipped == column) {
+                    ++field;
+                    break;
+                }
+            }
+        }
+        if (field < eol && ParseTraceField(field, eol, values[count])) {
+            if (++count == kTraceBatch) {
+                ok = sink.Push(values, count);
+                count = 0;
+            }
+        } else if (eol > pos && !(eol - pos == 1 && *pos == '\r')) {
+            ++stats.skipped;
+        }
+        pos = (eol < end) ? eol + 1 : end;
+    }
+    if (count > 0U && ok) {
+        ok = sink.Push(values, count);
+    }
+    return (size_t)(pos - data);
+}
+
+template <typename T>
+TraceWriter<T>::TraceWriter(FILE* file, bool text, TraceStats& stats) : file_(file), text_(text), stats_(stats) {
+    buffer_.resize(kTraceBlock + 64U);
+}
+
+template <typename T> bool TraceWriter<T>::Put(const T* medians, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (used_ >= kTraceBlock && !Flush()) {
+            return false;
+        }
+        char* pos = buffer_.data() + used_;
+        if (text_) {
+            // 64 spare bytes hold the longest number and a new line
+            auto result = std::to_chars(pos, buffer_.data() + buffer_.size() - 1U, medians[i]);
+            *result.ptr = '\n';
+            used_ += (size_t)(result.ptr + 1 - pos);
+        } else {
+            StoreLe(medians[i], (unsigned char*)pos);
+            used_ += sizeof(T);
+        }
+    }
+    stats_.medians += count;
+    return true;
+}
+
+template <typename T> bool TraceWriter<T>::Flush() {
+    if (used_ > 0U && std::fwrite(buffer_.data(), 1, used_, file_) != used_) {
+        return false;
+    }
+    stats_.bytes_out += used_;
+    used_ = 0;
+    return true;
+}
+
+} // namespace common
+
+// RMTRACE_INL
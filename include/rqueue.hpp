@@ -1,100 +1,141 @@
-// RQUEUE_HPP
-#pragma once
-
-#include <stdbool.h>
-#include <stdint.h>
-
-namespace common {
-
-typedef void (*LockCb)(void);
-typedef void (*UnlockCb)(void);
-
-#define CONTAINER_LOCK()                                                                                               \
-    do {                                                                                                               \
-        if (nullptr != lock_cb_) {                                                                                     \
-            lock_cb_();                                                                                                \
-        }                                                                                                              \
-    } while (0)
-
-#define CONTAINER_UNLOCK()                                                                                             \
-    do {                                                                                                               \
-        if (nullptr != unlock_cb_) {                                                                                   \
-            unlock_cb_();                                                                                              \
-        }                                                                                                              \
-    } while (0)
-
-/// @brief Class for circular/round constant queue objects handling.
-template <typename T, const uint8_t kSize> class Rqueue {
-  public:
-    Rqueue() = default;
-
-    void RegisterCallbacks(LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
-
-    /**
-     * @brief Returns a reference to a queue's head object.
-     */
-    const T& Head();
-
-    /**
-     * @brief Returns a reference to a queue's tail object.
-     */
-    const T& Tail();
-
-    /**
-     * @brief Returns a queue's object by index.
-     */
-    const T& operator[](uint8_t index);
-
-    /**
-     * @brief Returns a queue's current size.
-     */
-    uint8_t Size();
-
-    /**
-     * @brief Adds an object to the queue with replacement of the oldest
-     * one if the queue is full.
-     *
-     * @param container an object of queue<T> type.
-     */
-    void Add(T container);
-
-    /**
-     * @brief Adds an object to the queue only if the queue is not full.
-     *
-     * @param container an object of queue<T> type.
-     */
-    bool TryAdd(T container);
-
-    /**
-     * @brief Deletes an object from head (by moving head).
-     */
-    void DeleteHead();
-
-    /**
-     * @brief Deletes an object from tail (by shrinking size).
-     */
-    void DeleteTail();
-
-    /**
-     * @brief Deletes all objects from the queue.
-     */
-    void DeleteAll();
-
-  private:
-    void AddToTail(T container);
-    void IncrementPos();
-
-    T queue_[kSize]{};
-    uint8_t queue_pos_{};
-    uint8_t queue_size_{};
-
-    LockCb lock_cb_{nullptr};
-    UnlockCb unlock_cb_{nullptr};
-};
-
-} // namespace common
-
-// Here comes the implementation.
-#include "rqueue.inl"
-
-// RQUEUE_END
+// RQUEUE_HPP
+#pragma once
+
+#include "rmpolicy.hpp"
+#include <stdbool.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for circular/round constant queue objects handling.
+///
+/// LockPolicy (see rmpolicy.hpp) is resolved at compile time, NoLock has no storage and no code.
+/// Positions wrap by a bit mask for a power of two kSize and by one compare otherwise, there is no division.
+/// PushN(), PopN() and Spans() move or show a number of objects under one lock, as at most two blocks
+/// (up to the end of the array and from its beginning), so the queue is an ingest buffer for AddBatch().
+/// Size type is the smallest unsigned type for kSize, so small queues stay small.
+template <typename T, const uint32_t kSize, typename LockPolicy = CallbackLock> class Rqueue : private LockPolicy {
+  public:
+    Rqueue() = default;
+    static_assert(kSize > 0U && kSize <= 0x80000000U, "kSize must be in range 1..2^31");
+
+    using SizeType = typename std::conditional<
+        kSize <= 0xFFU, uint8_t, typename std::conditional<kSize <= 0xFFFFU, uint16_t, uint32_t>::type>::type;
+
+    /// @brief Contiguous objects of the queue, valid until the next change of the queue.
+    struct Span {
+        const T* data;
+        uint32_t size;
+    };
+
+    /// @brief Objects of the queue from the head: first up to the end of the array, then second from its beginning.
+    struct SpanPair {
+        Span first;
+        Span second;
+    };
+
+    /*
+     * @brief if you need to use lock function for multithreading (CallbackLock policy only)
+     */
+    void RegisterCallbacks(LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief Returns a copy of a queue's head object, taken under the lock.
+     */
+    T Head();
+
+    /**
+     * @brief Returns a copy of a queue's tail object, taken under the lock.
+     */
+    T Tail();
+
+    /**
+     * @brief Returns a copy of a queue's object by index, taken under the lock.
+     */
+    T operator[](uint32_t index);
+
+    /**
+     * @brief Returns a queue's current size.
+     */
+    SizeType Size();
+
+    /**
+     * @brief Adds an object to the queue with replacement of the oldest
+     * one if the queue is full.
+     *
+     * @param container an object of queue<T> type.
+     */
+    void Add(T container);
+
+    /**
+     * @brief Adds an object to the queue only if the queue is not full.
+     *
+     * @param container an object of queue<T> type.
+     */
+    bool TryAdd(T container);
+
+    /**
+     * @brief Adds objects to the queue, as many as there is free space for (no replacement), by two block copies.
+     *
+     * @param data objects to add.
+     * @param count count of objects.
+     * @return count of added objects.
+     */
+    uint32_t PushN(const T* data, uint32_t count);
+
+    /**
+     * @brief Takes objects from the queue head, by two block copies.
+     *
+     * @param out receives objects.
+     * @param count maximum count of objects to take.
+     * @return count of objects taken.
+     */
+    uint32_t PopN(T* out, uint32_t count);
+
+    /**
+     * @brief Returns all objects of the queue without a copy, taken under the lock.
+     * Spans are valid until the next change of the queue, DeleteHead(count) releases objects, which are read.
+     */
+    SpanPair Spans();
+
+    /**
+     * @brief Deletes an object from head (by moving head).
+     */
+    void DeleteHead();
+
+    /**
+     * @brief Deletes up to count objects from head (by moving head).
+     *
+     * @param count count of objects to delete.
+     */
+    void DeleteHead(uint32_t count);
+
+    /**
+     * @brief Deletes an object from tail (by shrinking size).
+     */
+    void DeleteTail();
+
+    /**
+     * @brief Deletes all objects from the queue.
+     */
+    void DeleteAll();
+
+  private:
+    static constexpr bool kPowerOfTwo = (kSize & (kSize - 1U)) == 0U;
+
+    static SizeType Index(uint32_t pos);
+    void AddToTail(T container);
+    void IncrementPos();
+
+    T queue_[kSize]{};
+    SizeType queue_pos_{};
+    SizeType queue_size_{};
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "rqueue.inl"
+
+// RQUEUE_END
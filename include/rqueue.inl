@@ -1,143 +1,226 @@
-// RQUEUE_INL
-// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
-#pragma once
-
-#include "rqueue.hpp"
-
-namespace common {
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::IncrementPos() {
-    queue_pos_ = (uint8_t)((queue_pos_ + 1U) % kSize);
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::AddToTail(T container) {
-    if (queue_size_ < kSize) {
-        queue_size_++;
-    } else {
-        IncrementPos();
-    }
-
-    queue_[(uint8_t)((queue_pos_ + queue_size_ - 1U) % kSize)] = container;
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::RegisterCallbacks(LockCb lock_cb, UnlockCb unlock_cb) {
-    lock_cb_ = lock_cb;
-    unlock_cb_ = unlock_cb;
-}
-
-template <typename T, const uint8_t kSize> const T& Rqueue<T, kSize>::Head() {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    uint8_t item_idx = queue_pos_;
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-
-    return queue_[item_idx];
-}
-
-template <typename T, uint8_t kSize> const T& Rqueue<T, kSize>::Tail() {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    uint8_t item_idx = (uint8_t)((queue_pos_ + queue_size_ - 1U) % kSize);
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-
-    return queue_[item_idx];
-}
-
-template <typename T, uint8_t kSize> const T& Rqueue<T, kSize>::operator[](uint8_t index) {
-
-    uint8_t item_idx = 0;
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    if (index < queue_size_) {
-        item_idx = (uint8_t)((queue_pos_ + index) % kSize);
-    } else {
-        // Safety fuse.
-        item_idx = 0U;
-    }
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-
-    return queue_[item_idx];
-}
-
-template <typename T, uint8_t kSize> uint8_t Rqueue<T, kSize>::Size() {
-
-    uint8_t qsize = 0;
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    qsize = queue_size_;
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-
-    return qsize;
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::Add(T container) {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    AddToTail(container);
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-}
-
-template <typename T, uint8_t kSize> bool Rqueue<T, kSize>::TryAdd(T container) {
-
-    bool status = false;
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    if (queue_size_ < kSize) {
-        AddToTail(container);
-        status = true;
-    } else {
-        status = false;
-    }
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-
-    return status;
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::DeleteHead() {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    if (queue_size_) {
-        queue_size_--;
-        IncrementPos();
-    }
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::DeleteTail() {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    if (queue_size_) {
-        queue_size_--;
-    }
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-}
-
-template <typename T, uint8_t kSize> void Rqueue<T, kSize>::DeleteAll() {
-
-    CONTAINER_LOCK(); // Critical region: Enter
-
-    queue_size_ = 0U;
-    queue_pos_ = 0U;
-
-    CONTAINER_UNLOCK(); // Critical region: Exit
-}
-
-} // namespace common
-
-// RQUEUE_INL
+// RQUEUE_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rqueue.hpp"
+
+#include <algorithm>
+
+namespace common {
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+typename Rqueue<T, kSize, LockPolicy>::SizeType Rqueue<T, kSize, LockPolicy>::Index(uint32_t pos) {
+    // pos is less than 2 * kSize
+    if constexpr (kPowerOfTwo) {
+        return (SizeType)(pos & (kSize - 1U));
+    } else {
+        return (SizeType)((pos >= kSize) ? pos - kSize : pos);
+    }
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::IncrementPos() {
+    queue_pos_ = Index(queue_pos_ + 1U);
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::AddToTail(T container) {
+    if (queue_size_ < kSize) {
+        queue_size_++;
+    } else {
+        IncrementPos();
+    }
+
+    queue_[Index(queue_pos_ + queue_size_ - 1U)] = container;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+void Rqueue<T, kSize, LockPolicy>::RegisterCallbacks(LockCb lock_cb, UnlockCb unlock_cb) {
+    this->RegisterLockCallbacks(lock_cb, unlock_cb);
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> T Rqueue<T, kSize, LockPolicy>::Head() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    T item = queue_[queue_pos_];
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return item;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> T Rqueue<T, kSize, LockPolicy>::Tail() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    T item = queue_[(queue_size_ > 0U) ? Index(queue_pos_ + queue_size_ - 1U) : queue_pos_];
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return item;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> T Rqueue<T, kSize, LockPolicy>::operator[](uint32_t index) {
+
+    SizeType item_idx = 0;
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (index < queue_size_) {
+        item_idx = Index(queue_pos_ + index);
+    } else {
+        // Safety fuse.
+        item_idx = 0U;
+    }
+
+    T item = queue_[item_idx];
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return item;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+typename Rqueue<T, kSize, LockPolicy>::SizeType Rqueue<T, kSize, LockPolicy>::Size() {
+
+    SizeType qsize = 0;
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    qsize = queue_size_;
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return qsize;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::Add(T container) {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    AddToTail(container);
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> bool Rqueue<T, kSize, LockPolicy>::TryAdd(T container) {
+
+    bool status = false;
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (queue_size_ < kSize) {
+        AddToTail(container);
+        status = true;
+    } else {
+        status = false;
+    }
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return status;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+uint32_t Rqueue<T, kSize, LockPolicy>::PushN(const T* data, uint32_t count) {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (count > kSize - queue_size_) {
+        count = kSize - queue_size_;
+    }
+
+    // the tail part of the array first, then its beginning
+    const uint32_t tail = Index(queue_pos_ + queue_size_);
+    const uint32_t first = std::min(count, kSize - tail);
+    std::copy_n(data, first, queue_ + tail);
+    std::copy_n(data + first, count - first, queue_);
+    queue_size_ = (SizeType)(queue_size_ + count);
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return count;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+uint32_t Rqueue<T, kSize, LockPolicy>::PopN(T* out, uint32_t count) {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (count > queue_size_) {
+        count = queue_size_;
+    }
+
+    const uint32_t first = std::min(count, kSize - queue_pos_);
+    std::copy_n(queue_ + queue_pos_, first, out);
+    std::copy_n(queue_, count - first, out + first);
+    queue_pos_ = Index(queue_pos_ + count);
+    queue_size_ = (SizeType)(queue_size_ - count);
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return count;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+typename Rqueue<T, kSize, LockPolicy>::SpanPair Rqueue<T, kSize, LockPolicy>::Spans() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    const uint32_t first = std::min<uint32_t>(queue_size_, kSize - queue_pos_);
+    const SpanPair spans{{queue_ + queue_pos_, first}, {queue_, queue_size_ - first}};
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+
+    return spans;
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::DeleteHead() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (queue_size_) {
+        queue_size_--;
+        IncrementPos();
+    }
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy>
+void Rqueue<T, kSize, LockPolicy>::DeleteHead(uint32_t count) {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (count > queue_size_) {
+        count = queue_size_;
+    }
+    queue_size_ = (SizeType)(queue_size_ - count);
+    queue_pos_ = Index(queue_pos_ + count);
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::DeleteTail() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    if (queue_size_) {
+        queue_size_--;
+    }
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+}
+
+template <typename T, uint32_t kSize, typename LockPolicy> void Rqueue<T, kSize, LockPolicy>::DeleteAll() {
+
+    CONTAINER_LOCK(); // Critical region: Enter
+
+    queue_size_ = 0U;
+    queue_pos_ = 0U;
+
+    CONTAINER_UNLOCK(); // Critical region: Exit
+}
+
+} // namespace common
+
+// RQUEUE_INL
@@ -0,0 +1,71 @@
+// RQUEUESPSC_HPP
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Lock-free circular queue for one producer thread and one consumer thread.
+///
+/// It has the same layout as Rqueue (array of kSize objects, head and tail), but head is moved
+/// by the consumer only and tail is moved by the producer only, both are atomic, so no lock is needed.
+/// Positions run from 0 to 2 * kSize - 1 to distinguish the full queue from the empty one.
+template <typename T, const uint32_t kSize> class RqueueSpsc {
+  public:
+    RqueueSpsc() = default;
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(kSize > 0U && kSize < 0x80000000U, "kSize must be in range 1..2^31-1");
+
+    /**
+     * @brief Adds an object to the queue only if the queue is not full. Producer thread only.
+     *
+     * @param container an object of queue<T> type.
+     */
+    bool TryPush(T container);
+
+    /**
+     * @brief Takes an object from the queue head if the queue is not empty. Consumer thread only.
+     *
+     * @param container receives the object.
+     */
+    bool TryPop(T& container);
+
+    /**
+     * @brief Takes up to count objects from the queue head. Consumer thread only.
+     *
+     * @param out receives objects.
+     * @param count maximum count of objects to take.
+     * @return count of objects taken.
+     */
+    uint32_t PopN(T* out, uint32_t count);
+
+    /**
+     * @brief Returns a queue's current size. It may be already changed by another thread.
+     */
+    uint32_t Size() const;
+
+    /**
+     * @brief Deletes all objects from the queue. Not thread safe.
+     */
+    void DeleteAll();
+
+  private:
+    static uint32_t Next(uint32_t pos);
+    static uint32_t Index(uint32_t pos);
+    static uint32_t Distance(uint32_t head, uint32_t tail);
+
+    T queue_[kSize]{};
+    alignas(64) std::atomic<uint32_t> head_{0U}; // written by consumer
+    alignas(64) std::atomic<uint32_t> tail_{0U}; // written by producer
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "rqueuespsc.inl"
+
+// RQUEUESPSC_END
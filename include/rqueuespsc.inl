@@ -0,0 +1,69 @@
+// RQUEUESPSC_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rqueuespsc.hpp"
+
+namespace common {
+
+template <typename T, uint32_t kSize> uint32_t RqueueSpsc<T, kSize>::Next(uint32_t pos) {
+    return (pos + 1U == 2U * kSize) ? 0U : pos + 1U;
+}
+
+template <typename T, uint32_t kSize> uint32_t RqueueSpsc<T, kSize>::Index(uint32_t pos) {
+    return (pos >= kSize) ? pos - kSize : pos;
+}
+
+template <typename T, uint32_t kSize> uint32_t RqueueSpsc<T, kSize>::Distance(uint32_t head, uint32_t tail) {
+    return (tail >= head) ? tail - head : tail + 2U * kSize - head;
+}
+
+template <typename T, uint32_t kSize> bool RqueueSpsc<T, kSize>::TryPush(T container) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+
+    if (Distance(head, tail) == kSize)
+        return false;
+
+    queue_[Index(tail)] = container;
+    tail_.store(Next(tail), std::memory_order_release);
+
+    return true;
+}
+
+template <typename T, uint32_t kSize> bool RqueueSpsc<T, kSize>::TryPop(T& container) {
+    return PopN(&container, 1U) == 1U;
+}
+
+template <typename T, uint32_t kSize> uint32_t RqueueSpsc<T, kSize>::PopN(T* out, uint32_t count) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+
+    const uint32_t available = Distance(head, tail);
+    if (count > available)
+        count = available;
+
+    uint32_t pos = head;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = queue_[Index(pos)];
+        pos = Next(pos);
+    }
+    head_.store(pos, std::memory_order_release);
+
+    return count;
+}
+
+template <typename T, uint32_t kSize> uint32_t RqueueSpsc<T, kSize>::Size() const {
+    const uint32_t size = Distance(head_.load(std::memory_order_acquire), tail_.load(std::memory_order_acquire));
+    // positions are read one by one, so the consumer may have moved head meanwhile
+    return (size > kSize) ? kSize : size;
+}
+
+template <typename T, uint32_t kSize> void RqueueSpsc<T, kSize>::DeleteAll() {
+    head_.store(0U, std::memory_order_relaxed);
+    tail_.store(0U, std::memory_order_relaxed);
+}
+
+} // namespace common
+
+// RQUEUESPSC_INL
@@ -0,0 +1,114 @@
+// RUNEXTREMES_HPP
+#pragma once
+
+#include "rmpolicy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for running minimum, maximum and range of the last kSize values
+///
+/// It keeps two monotonic deques (rings as Rqueue, from the head to the tail): the maximum deque has values
+/// going down, the minimum one has values going up, so the extremes are at the heads.
+/// A new value drops values from the tail, which can not be an extreme any more while it is in the window,
+/// and the head is dropped, when it leaves the window. Add() is amortized O(1), Min() and Max() are O(1),
+/// there is no sorted array and no array of all values in order of appearance: a deque keeps its values with
+/// their arrival numbers.
+/// If Runmedian is kept for the same values anyway, its Rank(0) and Rank(Size() - 1) are the extremes for free.
+///
+/// LockPolicy and ErrorPolicy are the same as for Runmedian.
+template <typename TRMValueType, const uint8_t kSize, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class RunExtremes : private LockPolicy, private ErrorPolicy {
+  public:
+    RunExtremes() = default;
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(kSize > 0U, "kSize must be in range 1..255");
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running minimum value
+     */
+    TRMValueType Min() const;
+
+    /**
+     * @brief running maximum value
+     */
+    TRMValueType Max() const;
+
+    /**
+     * @brief running range, Max() - Min(), taken under one lock
+     */
+    TRMValueType Range() const;
+
+    /**
+     * @brief Returns a size of values set, being used for calculating extremes.
+     */
+    uint8_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating extremes
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values.
+     *
+     * @param container another value for calculating extremes.
+     */
+    void Add(TRMValueType container);
+
+    /**
+     * @brief Adds a number of values under one lock, optionally with running extremes after every value.
+     *
+     * @param data values for calculating extremes.
+     * @param count count of values.
+     * @param min_out if not nullptr, receives running minimum after every value (count items).
+     * @param max_out if not nullptr, receives running maximum after every value (count items).
+     */
+    void AddBatch(const TRMValueType* data, size_t count, TRMValueType* min_out = nullptr,
+                  TRMValueType* max_out = nullptr);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks that deques are monotonic and their values are in the window
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    /// @brief Ring of values with arrival numbers, values are monotonic from the head to the tail.
+    struct Deque {
+        TRMValueType values[kSize];
+        uint8_t arrivals[kSize]; // arrival number of a value, it wraps, so only differences are used
+        uint8_t head;
+        uint8_t size;
+    };
+
+    template <bool kMax> static void Push(Deque& deque, TRMValueType val, uint8_t arrival);
+    static uint8_t Slot(const Deque& deque, uint32_t index);
+    void Insert(TRMValueType val);
+
+    Deque min_{};           // values going up, the minimum at the head
+    Deque max_{};           // values going down, the maximum at the head
+    uint8_t arrival_{};     // arrival number of the next value
+    uint8_t values_count{}; // used to fill window from 0 to kSize
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runextremes.inl"
+
+// RUNEXTREMES_END
@@ -0,0 +1,185 @@
+// RUNEXTREMES_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runextremes.hpp"
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                  LockCb lock_cb,
+                                                                                  UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Slot(const Deque& deque, uint32_t index) {
+    const uint32_t slot = deque.head + index;
+    return (uint8_t)(slot >= kSize ? slot - kSize : slot);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+template <bool kMax>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Push(Deque& deque, TRMValueType val,
+                                                                     uint8_t arrival) {
+    // the head leaves the window kSize values after its arrival, one value leaves it at most
+    if (deque.size > 0U && (uint8_t)(arrival - deque.arrivals[deque.head]) >= kSize) {
+        deque.head = Slot(deque, 1U);
+        deque.size--;
+    }
+
+    // values of the tail, which are not better than the new one, will never be an extreme
+    while (deque.size > 0U) {
+        const TRMValueType tail = deque.values[Slot(deque, deque.size - 1U)];
+        if (kMax ? val < tail : tail < val)
+            break;
+        deque.size--;
+    }
+
+    const uint8_t slot = Slot(deque, deque.size);
+    deque.values[slot] = val;
+    deque.arrivals[slot] = arrival;
+    deque.size++;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Insert(TRMValueType val) {
+    Push<false>(min_, val, arrival_);
+    Push<true>(max_, val, arrival_);
+    arrival_++;
+    if (values_count < kSize) {
+        values_count++;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Min() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    if (values_count > 0U) {
+        retval = min_.values[min_.head];
+    }
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Max() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    if (values_count > 0U) {
+        retval = max_.values[max_.head];
+    }
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Range() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    if (values_count > 0U) {
+        retval = (TRMValueType)(max_.values[max_.head] - min_.values[min_.head]);
+    }
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Size() const {
+    return values_count;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return values_count == 0U;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Add(TRMValueType val) {
+    CONTAINER_LOCK();
+    Insert(val);
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::AddBatch(const TRMValueType* data, size_t count,
+                                                                         TRMValueType* min_out,
+                                                                         TRMValueType* max_out) {
+    HANDLE_ERRORV(data != nullptr || count == 0U);
+
+    CONTAINER_LOCK();
+    for (size_t i = 0; i < count; i++) {
+        Insert(data[i]);
+        if (min_out != nullptr) {
+            min_out[i] = min_.values[min_.head];
+        }
+        if (max_out != nullptr) {
+            max_out[i] = max_.values[max_.head];
+        }
+    }
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    min_ = Deque{};
+    max_ = Deque{};
+    arrival_ = 0;
+    values_count = 0;
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool RunExtremes<TRMValueType, kSize, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (values_count > kSize)
+        return false;
+
+    const Deque* deques[] = {&min_, &max_};
+    for (const Deque* deque : deques) {
+        if (deque->head >= kSize || deque->size > values_count || (values_count > 0U && deque->size == 0U))
+            return false;
+
+        for (uint32_t i = 0; i < deque->size; i++) {
+            const uint8_t slot = Slot(*deque, i);
+            // arrivals go up from the head and every value is in the window
+            const uint8_t age = (uint8_t)(arrival_ - 1U - deque->arrivals[slot]);
+            if (age >= values_count)
+                return false;
+            if (i > 0U) {
+                const uint8_t prev = Slot(*deque, i - 1U);
+                const uint8_t prev_age = (uint8_t)(arrival_ - 1U - deque->arrivals[prev]);
+                const bool monotonic = deque == &min_ ? deque->values[prev] < deque->values[slot]
+                                                      : deque->values[slot] < deque->values[prev];
+                if (prev_age <= age || !monotonic)
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace common
+
+// RUNEXTREMES_INL
@@ -1,78 +1,183 @@
-// RUNMEDIAN_HPP
-#pragma once
-
-#include "rqueue.hpp"
-#include <cstdint>
-#include <stdbool.h>
-#include <type_traits>
-
-namespace common {
-
-typedef void (*ErrorCb)(void);
-
-/// @brief Class for running median for set of values
-///
-/// It uses sorted set of values and a queue of values in order of appearance
-/// we do not sort array, we only insert at right place, but we need to remove
-/// the oldest value, which is the head of queue.
-/// Array is sorted from less to greater value.
-///
-template <typename TRMValueType, const uint8_t kSize> class Runmedian {
-  public:
-    Runmedian() = default;
-    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
-
-    /*
-     * @brief if you need to use lock function for multithreading and error handling
-     */
-    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
-
-    /**
-     * @brief running median value
-     */
-    TRMValueType Value() const;
-
-    /**
-     * @brief Returns a size of values set, being used for calculating running median.
-     */
-    uint8_t Size() const;
-
-    /**
-     * @brief checks that we have at least one value for calculating median
-     */
-    bool IsEmpty() const;
-
-    /**
-     * @brief Adds an object to set of values.
-     *
-     * @param container another value for calculating running median.
-     */
-    void Add(TRMValueType container);
-
-    /**
-     * @brief Deletes all objects from the set of values.
-     */
-    void Clear();
-
-    /**
-     * @brief Checks that values at queue are the same as at array
-     * @note for unit tests only! CPU bound function
-     */
-    bool _check_integrity();
-
-  private:
-    TRMValueType values_sorted[kSize]{}; // sorted from less to greater value
-    uint8_t values_count{};              // used to fill array from 0 to kSize
-    Rqueue<TRMValueType, kSize> values_queue{};
-
-    ErrorCb error_cb_{nullptr};
-    LockCb lock_cb_{nullptr};
-    UnlockCb unlock_cb_{nullptr};
-};
-
-} // namespace common
-
-// Here comes the implementation.
-#include "runmedian.inl"
-
-// RUNMEDIAN_END
+// RUNMEDIAN_HPP
+#pragma once
+
+#include "rmpolicy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+namespace detail {
+
+/**
+ * @brief Average of two middle values of an even set, shared by all median engines.
+ * Integral types are averaged with a shift (as it was always done), others are divided by two.
+ */
+template <typename TRMValueType> TRMValueType Midpoint(TRMValueType lo, TRMValueType hi);
+
+/**
+ * @brief Sorts a tiny array by the odd-even transposition sorting network, unrolled at compile time.
+ * It is kSize * (kSize - 1) / 2 pairs of min/max without branches.
+ */
+template <uint8_t kSize, typename TRMValueType> void SortingNetwork(TRMValueType* values);
+
+} // namespace detail
+
+/// @brief Class for running median for set of values
+///
+/// It uses sorted set of values and an order of appearance index (arrival slot -> sorted position)
+/// we do not sort array, we only insert at right place, but we need to remove
+/// the oldest value, which is at the head slot, so its position is known without search.
+/// Array is sorted from less to greater value.
+/// Windows up to 9 values keep values themselves in order of appearance instead of the index
+/// and sort them again by a sorting network on every Add(), it has no branches to mispredict.
+///
+/// LockPolicy and ErrorPolicy (see rmpolicy.hpp) are resolved at compile time: callbacks by default,
+/// NoLock and IgnoreError have no storage and no branches.
+/// StatsPolicy counts adds, compared and shifted values and time under the lock, see Stats(),
+/// NoStats is the default one, it has no storage and no code.
+///
+template <typename TRMValueType, const uint8_t kSize, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError, typename StatsPolicy = NoStats>
+class Runmedian : private LockPolicy, private ErrorPolicy, private StatsPolicy {
+  public:
+    Runmedian() = default;
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+
+    using ValueType = TRMValueType;
+    static constexpr uint8_t kWindow = kSize;
+    // state has no callbacks, so it may be saved as memory image (see rmcheckpoint.hpp)
+    static constexpr bool kPlainState = !LockPolicy::kCallbacks && !ErrorPolicy::kCallbacks;
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief Returns k-th smallest value of the set (0 is the minimum, Size() - 1 is the maximum).
+     *
+     * @param rank index of value at sorted set, must be less than Size().
+     */
+    TRMValueType Rank(uint8_t rank) const;
+
+    /**
+     * @brief Returns running quantile by nearest rank: value with index round(quantile * (Size() - 1)), halves up.
+     * The quantile is taken with 6 decimal digits, so the rank is the same as of Quantiles<kPermille>().
+     * There is no interpolation, so Quantile(0.5) differs from Value() for even count of values.
+     *
+     * @param quantile from 0.0 (minimum) to 1.0 (maximum).
+     */
+    TRMValueType Quantile(double quantile) const;
+
+    /**
+     * @brief Returns a number of quantiles of the same set of values under one lock.
+     *
+     * @param quantiles values from 0.0 to 1.0, see Quantile().
+     * @param count count of quantiles.
+     * @param out receives quantile values (count items).
+     */
+    void Quantiles(const double* quantiles, size_t count, TRMValueType* out) const;
+
+    /**
+     * @brief Returns a fixed set of quantiles, given in per mille (500 is the median, 990 is p99).
+     * Indexes for the full window are calculated at compile time.
+     *
+     * @param out receives quantile values, one per template argument.
+     */
+    template <uint16_t... kPermille> void Quantiles(TRMValueType* out) const;
+
+    /**
+     * @brief Returns running median absolute deviation: the median of |value - Value()| over the set.
+     * Deviations below and above the median are two sorted lists at the sorted set, the middle one is found by
+     * binary search over them, O(log(Size())) without a copy.
+     */
+    TRMValueType Mad() const;
+
+    /**
+     * @brief Returns a size of values set, being used for calculating running median.
+     */
+    uint8_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values.
+     *
+     * @param container another value for calculating running median.
+     */
+    void Add(TRMValueType container);
+
+    /**
+     * @brief Adds a number of values under one lock, optionally with running median after every value.
+     * It is the same as calling Add() and Value() for every value, but much faster for big batches.
+     *
+     * @param data values for calculating running median.
+     * @param count count of values.
+     * @param medians_out if not nullptr, receives running median after every value (count items).
+     */
+    void AddBatch(const TRMValueType* data, size_t count, TRMValueType* medians_out = nullptr);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Returns a snapshot of hot path counters (InstanceStats and ThreadStats policies only).
+     */
+    StatsCounters Stats() const;
+
+    /**
+     * @brief Checks that array is sorted and order of appearance index is consistent
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+    /**
+     * @brief Checks that count, head and positions stay inside the window, so the next Add() can not write out of it
+     * @note cheap check of state restored from outside (checkpoints), it does not check order of values
+     */
+    bool _check_bounds() const;
+
+  private:
+    // window shorter than one 16 bytes vector is searched by scalar code
+    static constexpr bool kVectorSearch = kSize * sizeof(TRMValueType) >= 16U;
+    // de-spiking windows keep values in order of appearance and are sorted again by a sorting network,
+    // it is a fixed sequence of min/max without data dependent branches
+    static constexpr bool kTinyWindow = kSize <= 9U;
+    using OrderType = typename std::conditional<kTinyWindow, TRMValueType, uint8_t>::type;
+
+    bool Insert(TRMValueType val);
+    bool InsertSorted(TRMValueType val);
+    bool InsertTiny(TRMValueType val);
+    TRMValueType Median() const;
+    TRMValueType Deviation(TRMValueType mid) const;
+    uint8_t QuantileIndex(double quantile) const;
+    static constexpr uint8_t NearestRank(uint32_t per_million, uint8_t count);
+
+    void MovePositions(uint8_t from, uint8_t to, uint8_t delta);
+
+    TRMValueType values_sorted[kSize]{}; // sorted from less to greater value
+    OrderType values_order[kSize]{};     // position at values_sorted for every slot in order of appearance,
+                                         // the value itself for tiny windows
+    uint8_t values_count{};              // used to fill array from 0 to kSize
+    uint8_t values_head{};               // slot of the oldest value, when array is full
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedian.inl"
+
+// RUNMEDIAN_END
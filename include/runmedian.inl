@@ -1,50 +1,99 @@
-#include "rqueue.hpp"
+#include "rmsimd.hpp"
 #include "runmedian.hpp"
 
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <limits>
+#include <utility>
 #include <stdbool.h>
 
 namespace common {
 
-#define HANDLE_ERROR(condition, retval)                                                                                \
-    do {                                                                                                               \
-        if (!(condition) && nullptr != error_cb_) {                                                                    \
-            error_cb_();                                                                                               \
-            return retval;                                                                                             \
-        }                                                                                                              \
-    } while (0)
-
-#define HANDLE_ERRORV(condition)                                                                                       \
-    do {                                                                                                               \
-        if (!(condition) && nullptr != error_cb_) {                                                                    \
-            error_cb_();                                                                                               \
-            return;                                                                                                    \
-        }                                                                                                              \
-    } while (0)
-
-template <typename TRMValueType, uint8_t kSize> uint8_t Runmedian<TRMValueType, kSize>::Size() const {
+namespace detail {
+
+template <typename TRMValueType> TRMValueType Midpoint(TRMValueType lo, TRMValueType hi) {
+    if constexpr (std::is_integral<TRMValueType>::value) {
+        return (TRMValueType)((lo + hi) >> 1);
+    } else {
+        return (TRMValueType)((lo + hi) / 2);
+    }
+}
+
+template <typename TRMValueType> void CompareExchange(TRMValueType& a, TRMValueType& b) {
+    const TRMValueType lo = b < a ? b : a;
+    const TRMValueType hi = a < b ? b : a; // min and max instructions have these operand orders
+    a = lo;
+    b = hi;
+}
+
+// comparator k of the network: round r has pairs (i, i + 1) for i = r % 2, r % 2 + 2, ...
+template <uint8_t kSize> constexpr uint8_t NetworkPairLow(size_t k) {
+    size_t round = 0;
+    for (;;) {
+        const size_t pairs = (kSize - (round & 1U)) / 2U;
+        if (k < pairs)
+            return (uint8_t)((round & 1U) + 2U * k);
+        k -= pairs;
+        round++;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, size_t... k>
+void SortingNetwork(TRMValueType* values, std::index_sequence<k...>) {
+    (void)values; // no pairs for one value
+    (CompareExchange(values[NetworkPairLow<kSize>(k)], values[NetworkPairLow<kSize>(k) + 1U]), ...);
+}
+
+template <uint8_t kSize, typename TRMValueType> void SortingNetwork(TRMValueType* values) {
+    SortingNetwork<TRMValueType, kSize>(values, std::make_index_sequence<(size_t)kSize * (kSize - 1U) / 2U>{});
+}
+
+} // namespace detail
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+uint8_t Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Size() const {
     return values_count;
 }
 
-template <typename TRMValueType, uint8_t kSize> bool Runmedian<TRMValueType, kSize>::IsEmpty() const {
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::IsEmpty() const {
     return values_count == 0;
 }
 
-template <typename TRMValueType, uint8_t kSize>
-void Runmedian<TRMValueType, kSize>::RegisterCallbacks(ErrorCb error_cb, LockCb lock_cb, UnlockCb unlock_cb) {
-    error_cb_ = error_cb;
-    lock_cb_ = lock_cb;
-    unlock_cb_ = unlock_cb;
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                             LockCb lock_cb,
+                                                                                             UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
 }
 
-template <typename TRMValueType, uint8_t kSize> TRMValueType Runmedian<TRMValueType, kSize>::Value() const {
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Median() const {
     TRMValueType retval{};
 
-    HANDLE_ERROR(values_count <= kSize, retval);
+    if (values_count == kSize) {
+        // the most usual case of the full window: index is a constant
+        constexpr uint8_t kIndex = (uint8_t)((kSize - 1U) / 2U);
+        if constexpr (kSize % 2U) {
+            return values_sorted[kIndex];
+        } else {
+            return detail::Midpoint(values_sorted[kIndex], values_sorted[kIndex + 1U]);
+        }
+    }
 
-    CONTAINER_LOCK();
     switch (values_count) {
     case 0:
         break;
@@ -54,114 +103,372 @@ template <typename TRMValueType, uint8_t kSize> TRMValueType Runmedian<TRMValueT
         break;
 
     default:
-        const uint8_t even = values_count % 2;
-        const uint8_t index = (uint8_t)((values_count >> 1) + even - 1); // half items
-        retval = even ? values_sorted[index] : (TRMValueType)((values_sorted[index] + values_sorted[index + 1]) >> 1);
+        // not full window of 2 and more values, it exists for kSize > 2 only
+        if constexpr (kSize > 2U) {
+            const uint8_t even = values_count % 2;
+            const uint8_t index = (uint8_t)((values_count >> 1) + even - 1); // half items
+            retval = even ? values_sorted[index] : detail::Midpoint(values_sorted[index], values_sorted[index + 1]);
+        }
         break;
     }
-    CONTAINER_UNLOCK();
 
     return retval;
 }
 
-template <typename TRMValueType, uint8_t kSize> bool Runmedian<TRMValueType, kSize>::_check_integrity() {
-    if (values_count < kSize)
-        return true;
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Value() const {
+    TRMValueType retval{};
 
-    TRMValueType qcopy[kSize];
-    uint8_t i;
-    for (i = 0; i < kSize; i++)
-        qcopy[i] = values_queue[i];
+    HANDLE_ERROR(values_count <= kSize, retval);
+
+    CONTAINER_LOCK_STATS();
+    retval = Median();
+    CONTAINER_UNLOCK_STATS();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Deviation(TRMValueType mid) const {
+    if (values_count == 0U)
+        return TRMValueType{};
+
+    // values up to the median (going down) and above it (going up) are two sorted lists of deviations,
+    // the first take deviations are split between them by binary search, as k-th value of two sorted arrays
+    const uint32_t below = (values_count + 1U) / 2U;
+    const uint32_t above = values_count - below;
+    const uint32_t take = (values_count + 1U) / 2U;
+    const TRMValueType* const upper = values_sorted + below;
+    const TRMValueType* const lower = values_sorted + below - 1U; // lower[-i] is i-th value going down
+
+    uint32_t lo = take > above ? take - above : 0U;
+    uint32_t hi = take < below ? take : below;
+    while (lo < hi) {
+        // i deviations from below are too few, if the next one is less than the last one taken from above
+        const uint32_t i = (lo + hi) / 2U;
+        if (mid - lower[-(int32_t)i] < upper[take - i - 1U] - mid) {
+            lo = i + 1U;
+        } else {
+            hi = i;
+        }
+    }
+
+    const uint32_t from_below = lo;
+    const uint32_t from_above = take - lo;
+    TRMValueType deviation{};
+    if (from_below > 0U) {
+        deviation = (TRMValueType)(mid - lower[-(int32_t)(from_below - 1U)]);
+    }
+    if (from_above > 0U && (from_below == 0U || deviation < upper[from_above - 1U] - mid)) {
+        deviation = (TRMValueType)(upper[from_above - 1U] - mid);
+    }
+    if (values_count % 2U) {
+        return deviation;
+    }
+
+    // the next deviation is the upper middle one
+    TRMValueType next{};
+    if (from_below < below) {
+        next = (TRMValueType)(mid - lower[-(int32_t)from_below]);
+    }
+    if (from_above < above && (from_below == below || upper[from_above] - mid < next)) {
+        next = (TRMValueType)(upper[from_above] - mid);
+    }
+    return detail::Midpoint(deviation, next);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Mad() const {
+    TRMValueType retval{};
+
+    HANDLE_ERROR(values_count <= kSize, retval);
+
+    CONTAINER_LOCK_STATS();
+    retval = Deviation(Median());
+    CONTAINER_UNLOCK_STATS();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Rank(uint8_t rank) const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK_STATS();
+    const bool status = rank < kSize && rank < values_count;
+    if (status) {
+        retval = values_sorted[rank];
+    }
+    CONTAINER_UNLOCK_STATS();
+
+    HANDLE_ERROR(status, retval);
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+uint8_t Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::QuantileIndex(double quantile) const {
+    // out of range quantiles are clamped to the minimum or maximum
+    if (!(quantile > 0.0))
+        return 0U;
+    if (quantile >= 1.0)
+        return (uint8_t)(values_count - 1U);
+    // a decimal quantile as 0.58 is not exact in binary, so it is rounded to per million first, then the rank
+    // is the same as of Quantiles<580>()
+    return NearestRank((uint32_t)(quantile * 1000000.0 + 0.5), values_count);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+constexpr uint8_t Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::NearestRank(uint32_t per_million,
+                                                                                                  uint8_t count) {
+    // round(per_million / 10^6 * (count - 1)), half up, in integers
+    return (uint8_t)((per_million * (uint32_t)(count - 1U) + 500000U) / 1000000U);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+TRMValueType Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Quantile(double quantile) const {
+    TRMValueType retval{};
+
+    HANDLE_ERROR(values_count <= kSize, retval);
+
+    CONTAINER_LOCK_STATS();
+    if (values_count > 0U) {
+        retval = values_sorted[QuantileIndex(quantile)];
+    }
+    CONTAINER_UNLOCK_STATS();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Quantiles(const double* quantiles,
+                                                                                     size_t count,
+                                                                                     TRMValueType* out) const {
+    HANDLE_ERRORV(values_count <= kSize && ((quantiles != nullptr && out != nullptr) || count == 0U));
+
+    CONTAINER_LOCK_STATS();
+    for (size_t i = 0; i < count; i++) {
+        out[i] = values_count > 0U ? values_sorted[QuantileIndex(quantiles[i])] : TRMValueType{};
+    }
+    CONTAINER_UNLOCK_STATS();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+template <uint16_t... kPermille>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Quantiles(TRMValueType* out) const {
+    static_assert(sizeof...(kPermille) > 0U, "at least one quantile is required");
+    static_assert(((kPermille <= 1000U) && ...), "quantiles are given in per mille, from 0 to 1000");
+
+    HANDLE_ERRORV(values_count <= kSize && out != nullptr);
+
+    CONTAINER_LOCK_STATS();
+    if (values_count == kSize) {
+        // the most usual case of the full window: all indexes are constants
+        size_t i = 0;
+        ((out[i++] = values_sorted[NearestRank(kPermille * 1000U, kSize)]), ...);
+    } else if (values_count > 0U) {
+        size_t i = 0;
+        ((out[i++] = values_sorted[NearestRank(kPermille * 1000U, values_count)]), ...);
+    } else {
+        size_t i = 0;
+        ((out[i++] = TRMValueType{}, (void)kPermille), ...);
+    }
+    CONTAINER_UNLOCK_STATS();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+StatsCounters Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Stats() const {
+    static_assert(StatsPolicy::kEnabled, "StatsPolicy has no counters");
+
+    CONTAINER_LOCK();
+    const StatsCounters retval = this->StatsSnapshot();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::_check_bounds() const {
+    if (values_count > kSize || (values_count < kSize && values_head != 0U) || values_head >= kSize)
+        return false;
 
-    std::sort(qcopy, qcopy + kSize);
-    for (i = 0; i < kSize; i++)
-        if (qcopy[i] != values_sorted[i])
+    if constexpr (!kTinyWindow) {
+        // positions are used as indexes of values_sorted, one pass over kSize bytes without branches
+        uint8_t outside = 0U;
+        for (uint8_t i = 0; i < values_count; i++) {
+            outside |= (uint8_t)(values_order[i] >= values_count);
+        }
+        if (outside != 0U)
             return false;
+    }
 
     return true;
 }
 
-template <typename TRMValueType, uint8_t kSize> void Runmedian<TRMValueType, kSize>::Add(TRMValueType val) {
-    CONTAINER_LOCK();
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::_check_integrity() {
+    if (!_check_bounds())
+        return false;
 
-    HANDLE_ERRORV(values_count <= kSize);
-    TRMValueType* ibegin = values_sorted;
-    TRMValueType* iend = ibegin + values_count;
-    TRMValueType* igreater = std::upper_bound(ibegin, iend, val);
-    TRMValueType* ierase = std::find(ibegin, iend, values_queue.Head());
-
-    values_queue.Add(val);
-
-    if (values_count + 1 > kSize) {
-        // we should always find the head from queue at array
-        HANDLE_ERRORV(ierase < iend && ierase >= ibegin);
-        // erase and insert
-        if (ierase > igreater) {
-            // erase from the right side after igreater
-            TRMValueType old = *igreater;
-            TRMValueType newold{};
-            bool has_newold = false;
-            *igreater = val;
-
-            for (TRMValueType* i = igreater + 1; i < iend; i++) {
-                if (i == ierase) {
-                    *i = old;
-                    has_newold = false;
-                    break; // do nothing after ierase
-                }
-
-                newold = *i;
-                has_newold = true;
-                *i = old;
-                old = newold;
-            }
-            // check last item
-            if (has_newold)
-                *(iend - 1) = newold;
-        } else {
-            if (igreater == ierase) {
-                // ierase is always inside array
-                HANDLE_ERRORV(ierase < iend);
-                *igreater = val;
-            } else {
-                // erase before insert (ierase < igreater < ibegin + values_count)
-                for (TRMValueType* i = ierase; i < igreater - 1; i++) { // do shift before insert
-                    HANDLE_ERRORV(i + 1 < iend);
-                    *i = *(i + 1);
-                }
-                // insert new value
-                HANDLE_ERRORV(igreater - 1 >= ibegin);
-                *(igreater - 1) = val;
-            }
+    uint8_t i;
+    if constexpr (kTinyWindow) {
+        // the sorted array has the same values as the window
+        TRMValueType window[kSize];
+        for (i = 0; i < values_count; i++) {
+            window[i] = values_order[i];
         }
+        std::sort(window, window + values_count);
+        return std::equal(window, window + values_count, values_sorted);
     } else {
-        // nothing to erase, only insert new value
-        if (igreater != iend) {
-            TRMValueType old = val;
-            // do shift right
-            while (igreater < iend + 1) {
-                TRMValueType newold = *igreater;
-                *igreater = old;
-                old = newold;
-                igreater++;
-            }
-        } else { // just add next value
-            HANDLE_ERRORV(values_count < kSize);
-            ibegin[values_count] = val;
+        bool used[kSize]{};
+        for (i = 0; i < values_count; i++) {
+            if (i > 0U && values_sorted[i] < values_sorted[i - 1U])
+                return false;
+            // every position is used by one slot only
+            if (values_order[i] >= values_count || used[values_order[i]])
+                return false;
+            used[values_order[i]] = true;
         }
+    }
+
+    return true;
+}
 
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::MovePositions(uint8_t from,
+                                                                                         uint8_t to,
+                                                                                         uint8_t delta) {
+    // positions from..to-1 are moved by delta (1 or 255 as -1)
+    simd::AddInRange(values_order, kSize, from, (uint8_t)(to - from), delta);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::InsertTiny(TRMValueType val) {
+    constexpr TRMValueType kGreatest = std::numeric_limits<TRMValueType>::has_infinity
+                                           ? std::numeric_limits<TRMValueType>::infinity()
+                                           : std::numeric_limits<TRMValueType>::max();
+
+    if (values_count < kSize) {
+        values_order[values_count] = val;
         values_count++;
-        HANDLE_ERRORV(values_count <= kSize);
+    } else {
+        values_order[values_head] = val;
+        values_head = (uint8_t)((values_head + 1U == kSize) ? 0U : values_head + 1U);
     }
-    CONTAINER_UNLOCK();
+
+    // not used slots are the greatest values, so they are sorted after all used ones
+    TRMValueType sorted[kSize];
+    uint32_t i;
+    for (i = 0; i < kSize; i++) {
+        sorted[i] = (i < values_count) ? values_order[i] : kGreatest;
+    }
+
+    detail::SortingNetwork<kSize>(sorted);
+    this->StatsAdd((uint32_t)kSize * (kSize - 1U) / 2U, 0U);
+
+    for (i = 0; i < kSize; i++) {
+        values_sorted[i] = sorted[i];
+    }
+
+    return true;
 }
 
-template <typename TRMValueType, uint8_t kSize> void Runmedian<TRMValueType, kSize>::Clear() {
-    CONTAINER_LOCK();
-    values_queue.DeleteAll();
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Insert(TRMValueType val) {
+    if constexpr (kTinyWindow) {
+        return InsertTiny(val);
+    } else {
+        return InsertSorted(val);
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+bool Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::InsertSorted(TRMValueType val) {
+    // insert position is the count of values not greater than the new one (upper bound)
+    uint32_t igreater = 0;
+    if constexpr (kVectorSearch) {
+        igreater = simd::CountNotGreater(values_sorted, values_count, val);
+    } else {
+        igreater = simd::CountNotGreater<TRMValueType>(values_sorted, values_count, val);
+    }
+
+    if (values_count < kSize) {
+        // nothing to erase, only insert new value, slots are used from 0 to kSize
+        memmove(values_sorted + igreater + 1, values_sorted + igreater,
+                (values_count - igreater) * sizeof(TRMValueType));
+        values_sorted[igreater] = val;
+        MovePositions((uint8_t)igreater, values_count, 1U);
+        values_order[values_count] = (uint8_t)igreater;
+        this->StatsAdd(values_count, values_count - igreater);
+        values_count++;
+    } else {
+        // the oldest value is at the head slot
+        const uint32_t ierase = values_order[values_head];
+        if (ierase >= values_count) {
+            return false;
+        }
+
+        // erase and insert with one move of values between erase and insert positions
+        if (ierase < igreater) {
+            igreater--;
+            memmove(values_sorted + ierase, values_sorted + ierase + 1, (igreater - ierase) * sizeof(TRMValueType));
+            MovePositions((uint8_t)(ierase + 1U), (uint8_t)(igreater + 1U), 0xFFU);
+        } else {
+            memmove(values_sorted + igreater + 1, values_sorted + igreater, (ierase - igreater) * sizeof(TRMValueType));
+            MovePositions((uint8_t)igreater, (uint8_t)ierase, 1U);
+        }
+        values_sorted[igreater] = val;
+        values_order[values_head] = (uint8_t)igreater;
+        this->StatsAdd(kSize, ierase < igreater ? igreater - ierase : ierase - igreater);
+        values_head = (uint8_t)((values_head + 1U == kSize) ? 0U : values_head + 1U);
+    }
+
+    return true;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Add(TRMValueType val) {
+    HANDLE_ERRORV(values_count <= kSize);
+
+    CONTAINER_LOCK_STATS();
+    const bool status = Insert(val);
+    CONTAINER_UNLOCK_STATS();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::AddBatch(const TRMValueType* data,
+                                                                                    size_t count,
+                                                                                    TRMValueType* medians_out) {
+    HANDLE_ERRORV(values_count <= kSize && (data != nullptr || count == 0U));
+
+    bool status = true;
+
+    CONTAINER_LOCK_STATS();
+    if (medians_out != nullptr) {
+        for (size_t i = 0; i < count && status; i++) {
+            status = Insert(data[i]);
+            medians_out[i] = Median();
+        }
+    } else {
+        for (size_t i = 0; i < count && status; i++) {
+            status = Insert(data[i]);
+        }
+    }
+    CONTAINER_UNLOCK_STATS();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename LockPolicy, typename ErrorPolicy, typename StatsPolicy>
+void Runmedian<TRMValueType, kSize, LockPolicy, ErrorPolicy, StatsPolicy>::Clear() {
+    CONTAINER_LOCK_STATS();
     memset(values_sorted, 0, sizeof(values_sorted));
+    memset(values_order, 0, sizeof(values_order));
     values_count = 0;
-    CONTAINER_UNLOCK();
+    values_head = 0;
+    CONTAINER_UNLOCK_STATS();
 }
 
 } // namespace common
@@ -0,0 +1,134 @@
+// RUNMEDIANBANK_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for running medians of many independent channels with the same window size
+///
+/// All channels are kept as a structure of arrays: row r of the sorted table has r-th value of every channel,
+/// row r of the ring has r-th arrival slot of every channel. Rows are contiguous and cache line aligned,
+/// so one update of a group of channels is a pass over kSize rows with the same min/max operations
+/// at every lane, which the compiler turns into vector code across channels.
+/// Unused sorted places (while a channel is not full yet) keep the greatest value of the type,
+/// so a not full channel is updated the same way as a full one.
+///
+/// AddAll() is the fast path: at 256 channels and kSize 19 it is 1.7 (float) to 2.4 (uint16_t) times faster than a
+/// separate Runmedian per channel on random input (RunMedianBench, BankAll/SeparateAll). Add() of scattered channels
+/// has to gather kSize rows per value, which are different cache lines, so it is no faster than separate Runmedians
+/// and slower for big banks; use the bank for scattered input only if it is mixed with AddAll().
+///
+/// Every channel gives the same running median as Runmedian with the same kSize.
+/// LockPolicy and ErrorPolicy are the same as for Runmedian, one lock is taken for a whole call.
+///
+/// @note object is big for big kChannels, so do not place it on stack.
+template <typename TRMValueType, const uint8_t kSize, const uint32_t kChannels, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class RunmedianBank : private LockPolicy, private ErrorPolicy {
+  public:
+    RunmedianBank();
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(kSize > 0U, "kSize must be in range 1..255");
+    static_assert(kChannels > 0U, "kChannels must be positive");
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value of a channel
+     *
+     * @param channel channel index, less than kChannels.
+     */
+    TRMValueType Value(uint32_t channel) const;
+
+    /**
+     * @brief Running median values of all channels under one lock.
+     *
+     * @param out receives kChannels values.
+     */
+    void Values(TRMValueType* out) const;
+
+    /**
+     * @brief Returns a size of values set of a channel.
+     *
+     * @param channel channel index, less than kChannels.
+     */
+    uint8_t Size(uint32_t channel) const;
+
+    /**
+     * @brief Adds an object to set of values of a channel.
+     *
+     * @param channel channel index, less than kChannels.
+     * @param container another value for calculating running median.
+     */
+    void Add(uint32_t channel, TRMValueType container);
+
+    /**
+     * @brief Adds values to channels in the given order: values[i] goes to channels[i].
+     * Values of different channels are updated together, a channel may be repeated.
+     *
+     * @param channels channel indexes, wrong indexes are skipped with error.
+     * @param values values for calculating running median.
+     * @param count count of channels and values.
+     */
+    void Add(const uint32_t* channels, const TRMValueType* values, size_t count);
+
+    /**
+     * @brief Adds one value to every channel: values[i] goes to channel i.
+     *
+     * @param values kChannels values.
+     */
+    void AddAll(const TRMValueType* values);
+
+    /**
+     * @brief Deletes all objects from the sets of values of all channels.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks sorted order, sentinels and that sorted and ring values of every channel are the same
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    // lanes of one dense group fill a cache line, a scatter group is smaller to keep the repeat check cheap
+    static constexpr uint32_t kLanes = sizeof(TRMValueType) < 64U ? 64U / sizeof(TRMValueType) : 1U;
+    static constexpr uint32_t kScatterLanes = kLanes < 16U ? kLanes : 16U;
+    static constexpr uint32_t kStride = (kChannels + kLanes - 1U) / kLanes * kLanes;
+    static constexpr TRMValueType kSentinel = std::numeric_limits<TRMValueType>::has_infinity
+                                                  ? std::numeric_limits<TRMValueType>::infinity()
+                                                  : std::numeric_limits<TRMValueType>::max();
+    // the row before the first one for Replace(), -inf is not clamped to the lowest finite value
+    static constexpr TRMValueType kLowest = std::numeric_limits<TRMValueType>::has_infinity
+                                                ? -std::numeric_limits<TRMValueType>::infinity()
+                                                : std::numeric_limits<TRMValueType>::lowest();
+    static_assert((uint64_t)(kSize + 1U) * kStride <= 0xFFFFFFFFU, "kChannels is too big for kSize");
+
+    template <uint32_t kRowStride, uint32_t kGroupLanes>
+    static void Replace(TRMValueType* rows, const TRMValueType* old, const TRMValueType* val);
+    TRMValueType Median(uint32_t channel) const;
+    TRMValueType Push(uint32_t channel, TRMValueType val);
+    void AddGroup(const uint32_t* channels, const TRMValueType* values, uint32_t lanes, TRMValueType* group);
+    void Reset();
+
+    alignas(64) TRMValueType sorted_[(kSize + 1U) * kStride]; // sorted values by rows, the last row is sentinels
+    alignas(64) TRMValueType ring_[kSize * kStride];          // values in order of appearance by rows
+    uint8_t head_[kStride];                                   // the oldest slot, when all slots are used
+    uint8_t count_[kStride];
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianbank.inl"
+
+// RUNMEDIANBANK_END
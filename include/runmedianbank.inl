@@ -0,0 +1,295 @@
+// RUNMEDIANBANK_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianbank.hpp"
+
+#include <algorithm>
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::RunmedianBank() {
+    Reset();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                               LockCb lock_cb,
+                                                                                               UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+template <uint32_t kRowStride, uint32_t kGroupLanes>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Replace(TRMValueType* rows,
+                                                                                     const TRMValueType* old,
+                                                                                     const TRMValueType* val) {
+    // Every lane removes old and inserts val at its sorted column. If val is not less than old,
+    // values between them move one row up, otherwise one row down:
+    //   up:   s[r] < old ? s[r] : min(s[r + 1], max(s[r], val))
+    //   down: s[r] > old ? s[r] : min(s[r], max(s[r - 1], val))
+    // Both are selected without branches, the row after the last one is sentinels.
+    // Local copies tell the compiler that lanes do not overlap the rows, and every lane value is loaded once,
+    // so the inner loop has no branches to stop vectorization.
+    TRMValueType prev[kGroupLanes];
+    TRMValueType out[kGroupLanes];
+    TRMValueType in[kGroupLanes];
+    uint32_t l;
+    for (l = 0; l < kGroupLanes; l++) {
+        prev[l] = kLowest;
+        out[l] = old[l];
+        in[l] = val[l];
+    }
+
+    for (uint32_t r = 0; r < kSize; r++) {
+        TRMValueType* row = rows + r * kRowStride;
+        const TRMValueType* next = row + kRowStride;
+        for (l = 0; l < kGroupLanes; l++) {
+            const TRMValueType s = row[l];
+            const TRMValueType n = next[l];
+            const TRMValueType p = prev[l];
+            const TRMValueType o = out[l];
+            const TRMValueType v = in[l];
+            const TRMValueType upper = s < v ? v : s;
+            const TRMValueType lower = p < v ? v : p;
+            const TRMValueType up = s < o ? s : (n < upper ? n : upper);
+            const TRMValueType down = o < s ? s : (s < lower ? s : lower);
+            prev[l] = s;
+            row[l] = v < o ? down : up;
+        }
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Median(uint32_t channel) const {
+    TRMValueType retval{};
+    const uint8_t count = count_[channel];
+
+    if (count > 0U) {
+        const uint8_t odd = count % 2;
+        const uint32_t index = (uint32_t)((count >> 1) + odd - 1); // half items
+        const TRMValueType lo = sorted_[index * kStride + channel];
+        retval = odd ? lo : detail::Midpoint(lo, sorted_[(index + 1U) * kStride + channel]);
+    }
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Value(uint32_t channel) const {
+    TRMValueType retval{};
+
+    HANDLE_ERROR(channel < kChannels, retval);
+
+    CONTAINER_LOCK();
+    retval = Median(channel);
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Values(TRMValueType* out) const {
+    HANDLE_ERRORV(out != nullptr);
+
+    CONTAINER_LOCK();
+    for (uint32_t c = 0; c < kChannels; c++) {
+        out[c] = Median(c);
+    }
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Size(uint32_t channel) const {
+    HANDLE_ERROR(channel < kChannels, 0U);
+
+    return count_[channel];
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Push(uint32_t channel,
+                                                                                          TRMValueType val) {
+    // stores the value at the ring and returns the value to erase, sentinel if the channel is not full
+    TRMValueType old = kSentinel;
+    const uint8_t count = count_[channel];
+
+    if (count < kSize) {
+        ring_[count * kStride + channel] = val;
+        count_[channel] = (uint8_t)(count + 1U);
+    } else {
+        const uint8_t head = head_[channel];
+        old = ring_[head * kStride + channel];
+        ring_[head * kStride + channel] = val;
+        head_[channel] = (uint8_t)((head + 1U == kSize) ? 0U : head + 1U);
+    }
+
+    return old;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::AddGroup(const uint32_t* channels,
+                                                                                      const TRMValueType* values,
+                                                                                      uint32_t lanes,
+                                                                                      TRMValueType* group) {
+    // sorted columns of different channels are gathered to a dense group, updated together and put back
+    TRMValueType old[kScatterLanes];
+    TRMValueType val[kScatterLanes];
+    uint32_t l;
+    uint32_t r;
+
+    for (l = 0; l < lanes; l++) {
+        val[l] = values[l];
+        old[l] = Push(channels[l], values[l]);
+        for (r = 0; r < kSize; r++) {
+            group[r * kScatterLanes + l] = sorted_[r * kStride + channels[l]];
+        }
+    }
+    for (; l < kScatterLanes; l++) {
+        val[l] = kSentinel;
+        old[l] = kSentinel;
+    }
+
+    Replace<kScatterLanes, kScatterLanes>(group, old, val);
+
+    for (l = 0; l < lanes; l++) {
+        for (r = 0; r < kSize; r++) {
+            sorted_[r * kStride + channels[l]] = group[r * kScatterLanes + l];
+        }
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Add(uint32_t channel,
+                                                                                 TRMValueType container) {
+    Add(&channel, &container, 1U);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Add(const uint32_t* channels,
+                                                                                 const TRMValueType* values,
+                                                                                 size_t count) {
+    HANDLE_ERRORV((channels != nullptr && values != nullptr) || count == 0U);
+
+    TRMValueType group[(kSize + 1U) * kScatterLanes];
+    uint32_t group_channels[kScatterLanes];
+    TRMValueType group_values[kScatterLanes];
+    uint32_t lanes = 0;
+    bool status = true;
+
+    std::fill(group, group + (kSize + 1U) * kScatterLanes, kSentinel);
+
+    CONTAINER_LOCK();
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t channel = channels[i];
+        if (channel >= kChannels) {
+            status = false;
+            continue;
+        }
+
+        // a repeated channel waits for the next group to keep order of its values
+        uint32_t* group_end = group_channels + lanes;
+        if (lanes == kScatterLanes || std::find(group_channels, group_end, channel) != group_end) {
+            AddGroup(group_channels, group_values, lanes, group);
+            lanes = 0;
+        }
+        group_channels[lanes] = channel;
+        group_values[lanes] = values[i];
+        lanes++;
+    }
+    if (lanes > 0U) {
+        AddGroup(group_channels, group_values, lanes, group);
+    }
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::AddAll(const TRMValueType* values) {
+    HANDLE_ERRORV(values != nullptr);
+
+    TRMValueType old[kLanes];
+    TRMValueType val[kLanes];
+
+    CONTAINER_LOCK();
+    for (uint32_t first = 0; first < kChannels; first += kLanes) {
+        // padding channels of the last group keep sentinels
+        for (uint32_t l = 0; l < kLanes; l++) {
+            const uint32_t channel = first + l;
+            if (channel < kChannels) {
+                val[l] = values[channel];
+                old[l] = Push(channel, values[channel]);
+            } else {
+                val[l] = kSentinel;
+                old[l] = kSentinel;
+            }
+        }
+
+        Replace<kStride, kLanes>(sorted_ + first, old, val);
+    }
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Reset() {
+    std::fill(sorted_, sorted_ + (kSize + 1U) * kStride, kSentinel);
+    std::fill(ring_, ring_ + kSize * kStride, TRMValueType{});
+    std::fill(head_, head_ + kStride, (uint8_t)0U);
+    std::fill(count_, count_ + kStride, (uint8_t)0U);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+void RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    Reset();
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kChannels, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianBank<TRMValueType, kSize, kChannels, LockPolicy, ErrorPolicy>::_check_integrity() {
+    TRMValueType column[kSize];
+    TRMValueType window[kSize];
+
+    for (uint32_t c = 0; c < kStride; c++) {
+        const uint8_t count = count_[c];
+        if (count > kSize || (count < kSize && head_[c] != 0U) || head_[c] >= kSize || (c >= kChannels && count != 0U))
+            return false;
+
+        uint32_t r;
+        for (r = 0; r <= kSize; r++) {
+            const TRMValueType s = sorted_[r * kStride + c];
+            if (r >= count && !(s == kSentinel))
+                return false;
+            if (r < count) {
+                column[r] = s;
+                window[r] = ring_[r * kStride + c];
+                if (r > 0U && s < column[r - 1U])
+                    return false;
+            }
+        }
+
+        // sorted column has the same values as the window
+        std::sort(window, window + count);
+        if (!std::equal(window, window + count, column))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace common
+
+// RUNMEDIANBANK_INL
@@ -0,0 +1,105 @@
+// RUNMEDIANHISTOGRAM_HPP
+#pragma once
+
+#include "rqueue.hpp"
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for running median of narrow unsigned values (bytes, 10-12 bits ADC samples)
+///
+/// It keeps a count of values for every possible value (a histogram) and a cursor at the bin
+/// of the lower middle value, with a count of values below the cursor bin. Add() is one increment,
+/// one decrement and a move of the cursor, the cost does not depend on kSize.
+/// The cursor skips empty bins, for kBins > 256 bins are grouped by 16 with a count for every group,
+/// so empty groups are skipped at once.
+/// Order of appearance is kept by Rqueue.
+///
+/// Value() is the same as Runmedian::Value() for the same values, including averaging of an even set.
+/// LockPolicy and ErrorPolicy are the same as for Runmedian, values not less than kBins are errors.
+template <typename TRMValueType, const uint8_t kSize,
+          const uint32_t kBins = 1U << (sizeof(TRMValueType) == 1U ? 8U : 12U), typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class RunmedianHistogram : private LockPolicy, private ErrorPolicy {
+  public:
+    RunmedianHistogram() = default;
+    static_assert(std::is_integral<TRMValueType>::value && std::is_unsigned<TRMValueType>::value,
+                  "TRMValueType must be unsigned integral");
+    static_assert(kSize > 0U, "kSize must be in range 1..255");
+    static_assert(kBins > 0U && kBins <= 0x10000U, "kBins must be in range 1..65536");
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief Returns a size of values set, being used for calculating running median.
+     */
+    uint8_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values.
+     *
+     * @param container another value for calculating running median, less than kBins.
+     */
+    void Add(TRMValueType container);
+
+    /**
+     * @brief Adds a number of values under one lock, optionally with running median after every value.
+     *
+     * @param data values for calculating running median, less than kBins.
+     * @param count count of values.
+     * @param medians_out if not nullptr, receives running median after every value (count items).
+     */
+    void AddBatch(const TRMValueType* data, size_t count, TRMValueType* medians_out = nullptr);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks histogram against the queue and the cursor position
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    static constexpr bool kTwoLevel = kBins > 256U;
+    static constexpr uint32_t kGroup = 16U; // bins in one group of the upper level
+    static constexpr uint32_t kGroups = kTwoLevel ? (kBins + kGroup - 1U) / kGroup : 1U;
+
+    uint32_t NextBin(uint32_t bin) const;
+    uint32_t PrevBin(uint32_t bin) const;
+    bool Push(TRMValueType val);
+    TRMValueType Median() const;
+
+    Rqueue<TRMValueType, kSize, NoLock> values_{}; // values in order of appearance
+    uint8_t bins_[kGroups * kGroup > kBins ? kGroups * kGroup : kBins]{}; // count of values for every value
+    uint8_t groups_[kGroups]{};                                            // count of values for every kGroup bins
+    uint32_t median_{};                                                    // bin of the lower middle value
+    uint8_t below_{};                                                      // count of values below median_ bin
+    uint8_t count_{};
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianhistogram.inl"
+
+// RUNMEDIANHISTOGRAM_END
@@ -0,0 +1,236 @@
+// RUNMEDIANHISTOGRAM_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianhistogram.hpp"
+
+#include <cstring>
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                                LockCb lock_cb,
+                                                                                                UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::NextBin(uint32_t bin) const {
+    // the nearest not empty bin above, caller knows that it exists
+    uint32_t next = bin + 1U;
+    if constexpr (kTwoLevel) {
+        for (; next % kGroup != 0U; next++) {
+            if (bins_[next] != 0U)
+                return next;
+        }
+        uint32_t group = next / kGroup;
+        while (groups_[group] == 0U)
+            group++;
+        next = group * kGroup;
+    }
+    while (bins_[next] == 0U)
+        next++;
+    return next;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::PrevBin(uint32_t bin) const {
+    // the nearest not empty bin below, caller knows that it exists
+    uint32_t prev = bin;
+    if constexpr (kTwoLevel) {
+        while (prev % kGroup != 0U) {
+            prev--;
+            if (bins_[prev] != 0U)
+                return prev;
+        }
+        uint32_t group = prev / kGroup;
+        while (groups_[group - 1U] == 0U)
+            group--;
+        prev = group * kGroup;
+    }
+    do {
+        prev--;
+    } while (bins_[prev] == 0U);
+    return prev;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Push(TRMValueType val) {
+    const uint32_t bin = (uint32_t)val;
+    if (bin >= kBins) {
+        return false;
+    }
+
+    if (count_ == 0U) {
+        median_ = bin;
+        below_ = 0U;
+    }
+
+    if (count_ < kSize) {
+        count_++;
+    } else {
+        // the oldest value leaves first, so a count never exceeds kSize,
+        // the median bin may become empty, the cursor moves out of it below
+        const uint32_t erase = (uint32_t)values_.Head();
+        bins_[erase]--;
+        if constexpr (kTwoLevel) {
+            groups_[erase / kGroup]--;
+        }
+        below_ = (uint8_t)(below_ - (erase < median_ ? 1U : 0U));
+    }
+
+    bins_[bin]++;
+    if constexpr (kTwoLevel) {
+        groups_[bin / kGroup]++;
+    }
+    below_ = (uint8_t)(below_ + (bin < median_ ? 1U : 0U));
+    values_.Add(val);
+
+    // the lower middle value has rank (count - 1) / 2
+    const uint32_t rank = (count_ - 1U) / 2U;
+    while (below_ > rank) {
+        median_ = PrevBin(median_);
+        below_ = (uint8_t)(below_ - bins_[median_]);
+    }
+    while (below_ + bins_[median_] <= rank) {
+        below_ = (uint8_t)(below_ + bins_[median_]);
+        median_ = NextBin(median_);
+    }
+
+    return true;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Median() const {
+    if (count_ == 0U) {
+        return TRMValueType{};
+    }
+
+    const TRMValueType lo = (TRMValueType)median_;
+    if (count_ % 2U) {
+        return lo;
+    }
+
+    // the upper middle value has the next rank, it is at the same bin or at the next not empty one
+    const uint32_t rank = count_ / 2U;
+    const TRMValueType hi = (TRMValueType)((below_ + bins_[median_] > rank) ? median_ : NextBin(median_));
+    return detail::Midpoint(lo, hi);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Value() const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = Median();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Size() const {
+    return count_;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return count_ == 0U;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Add(TRMValueType val) {
+    CONTAINER_LOCK();
+    const bool status = Push(val);
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::AddBatch(const TRMValueType* data,
+                                                                                       size_t count,
+                                                                                       TRMValueType* medians_out) {
+    HANDLE_ERRORV(data != nullptr || count == 0U);
+
+    bool status = true;
+
+    CONTAINER_LOCK();
+    if (medians_out != nullptr) {
+        for (size_t i = 0; i < count && status; i++) {
+            status = Push(data[i]);
+            medians_out[i] = Median();
+        }
+    } else {
+        for (size_t i = 0; i < count && status; i++) {
+            status = Push(data[i]);
+        }
+    }
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    values_.DeleteAll();
+    memset(bins_, 0, sizeof(bins_));
+    memset(groups_, 0, sizeof(groups_));
+    median_ = 0U;
+    below_ = 0U;
+    count_ = 0U;
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kBins, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianHistogram<TRMValueType, kSize, kBins, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (count_ > kSize || values_.Size() != count_)
+        return false;
+
+    // histogram is built again from the queue
+    uint8_t bins[sizeof(bins_)]{};
+    uint32_t i;
+    for (i = 0; i < count_; i++) {
+        bins[(uint32_t)values_[(uint8_t)i]]++;
+    }
+    if (memcmp(bins, bins_, sizeof(bins_)) != 0)
+        return false;
+
+    for (i = 0; i < kGroups && kTwoLevel; i++) {
+        uint32_t sum = 0;
+        for (uint32_t bin = i * kGroup; bin < (i + 1U) * kGroup; bin++) {
+            sum += bins_[bin];
+        }
+        if (sum != groups_[i])
+            return false;
+    }
+
+    if (count_ == 0U)
+        return true;
+
+    // the cursor is at the bin of the lower middle value
+    uint32_t below = 0;
+    for (i = 0; i < median_; i++) {
+        below += bins_[i];
+    }
+    const uint32_t rank = (count_ - 1U) / 2U;
+    return below == below_ && below <= rank && rank < below + bins_[median_];
+}
+
+} // namespace common
+
+// RUNMEDIANHISTOGRAM_INL
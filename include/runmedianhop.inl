@@ -0,0 +1,223 @@
+// RUNMEDIANHOP_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianhop.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                         LockCb lock_cb,
+                                                                                         UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Restore() {
+    if (pending_count_ == 0U)
+        return;
+
+    // pending values are sorted together with their sequence numbers
+    TRMValueType fresh[kPendingSize];
+    uint16_t fresh_seq[kPendingSize];
+    const uint32_t pending = std::min<uint32_t>(pending_count_, kPendingSize);
+    const uint16_t first = (uint16_t)(seq_ - pending);
+    if constexpr (kRankSort) {
+        // unlike insertion sort, compares of random values do not mispredict branches,
+        // equal values are ranked in order of appearance
+        for (uint32_t i = 0; i < pending; i++) {
+            uint32_t rank = 0;
+            for (uint32_t k = 0; k < i; k++) {
+                rank += (uint32_t)(pending_[k] <= pending_[i]);
+            }
+            for (uint32_t k = i + 1U; k < pending; k++) {
+                rank += (uint32_t)(pending_[k] < pending_[i]);
+            }
+            fresh[rank] = pending_[i];
+            fresh_seq[rank] = (uint16_t)(first + i);
+        }
+    } else {
+        std::pair<TRMValueType, uint16_t> items[kPendingSize];
+        for (uint32_t i = 0; i < pending; i++) {
+            items[i] = {pending_[i], (uint16_t)(first + i)};
+        }
+        // equal values may go in any order, only their count matters
+        std::sort(items, items + pending, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        for (uint32_t i = 0; i < pending; i++) {
+            fresh[i] = items[i].first;
+            fresh_seq[i] = items[i].second;
+        }
+    }
+
+    // one pass: pending values are merged and values older than the window are dropped without branches,
+    // the newest value has age 0; a dropped value is written past the kept ones, so one more slot.
+    // A pending value is taken kHop times at most, so the branch is mispredicted a few times per pass only.
+    TRMValueType merged[kSize + 1U];
+    uint16_t merged_seq[kSize + 1U];
+    const uint16_t newest = (uint16_t)(seq_ - 1U);
+    uint32_t out = 0;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < sorted_count_; i++) {
+        const TRMValueType val = values_sorted[i];
+        const uint16_t seq = values_seq[i];
+        while (j < pending && fresh[j] < val) {
+            merged[out] = fresh[j];
+            merged_seq[out] = fresh_seq[j];
+            out++;
+            j++;
+        }
+        merged[out] = val;
+        merged_seq[out] = seq;
+        out += (uint32_t)((uint16_t)(newest - seq) < values_count);
+    }
+    for (; j < pending; j++) {
+        merged[out] = fresh[j];
+        merged_seq[out] = fresh_seq[j];
+        out++;
+    }
+
+    memcpy(values_sorted, merged, out * sizeof(TRMValueType));
+    memcpy(values_seq, merged_seq, out * sizeof(uint16_t));
+    sorted_count_ = (uint8_t)out;
+    pending_count_ = 0;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Push(TRMValueType val) {
+    if (pending_count_ == kPendingSize) {
+        Restore();
+    }
+
+    pending_[pending_count_++] = val;
+    seq_++;
+    if (values_count < kSize) {
+        values_count++;
+    }
+    phase_ = (uint8_t)((phase_ + 1U == kHop) ? 0U : phase_ + 1U);
+    median_valid_ = false;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Median() {
+    if (median_valid_ || values_count == 0U) {
+        return median_;
+    }
+
+    Restore();
+    // the upper middle value of even count is at count / 2
+    const uint32_t index = (values_count - 1U) / 2U;
+    median_ = (values_count % 2U == 0U) ? detail::Midpoint(values_sorted[index], values_sorted[values_count / 2U])
+                                        : values_sorted[index];
+    median_valid_ = true;
+    return median_;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Value() {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    retval = Median();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Size() const {
+    return values_count;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return values_count == 0U;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Add(TRMValueType val) {
+    CONTAINER_LOCK();
+    Push(val);
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+size_t RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::AddBatch(const TRMValueType* data,
+                                                                                  size_t count,
+                                                                                  TRMValueType* medians_out) {
+    HANDLE_ERROR(data != nullptr || count == 0U, 0U);
+
+    size_t medians = 0;
+
+    CONTAINER_LOCK();
+    for (size_t i = 0; i < count; i++) {
+        Push(data[i]);
+        if (medians_out != nullptr && phase_ == 0U) {
+            medians_out[medians++] = Median();
+        }
+    }
+    CONTAINER_UNLOCK();
+
+    return medians;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+void RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    memset(values_sorted, 0, sizeof(values_sorted));
+    memset(values_seq, 0, sizeof(values_seq));
+    memset(pending_, 0, sizeof(pending_));
+    seq_ = 0;
+    values_count = 0;
+    sorted_count_ = 0;
+    pending_count_ = 0;
+    phase_ = 0;
+    median_ = TRMValueType{};
+    median_valid_ = false;
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint8_t kHop, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianHop<TRMValueType, kSize, kHop, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (values_count > kSize || pending_count_ > kPendingSize || pending_count_ > values_count ||
+        sorted_count_ > kSize)
+        return false;
+
+    // every value of the window older than pending ones is sorted once, by age
+    bool used[kSize]{};
+    uint32_t window = 0;
+    const uint16_t newest = (uint16_t)(seq_ - 1U);
+    for (uint32_t i = 0; i < sorted_count_; i++) {
+        if (i > 0U && values_sorted[i] < values_sorted[i - 1U])
+            return false;
+        const uint16_t age = (uint16_t)(newest - values_seq[i]);
+        if (age >= values_count)
+            continue;
+        if (age < pending_count_ || used[age])
+            return false;
+        used[age] = true;
+        window++;
+    }
+
+    return window + pending_count_ == values_count;
+}
+
+} // namespace common
+
+// RUNMEDIANHOP_INL
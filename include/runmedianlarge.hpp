@@ -0,0 +1,111 @@
+// RUNMEDIANLARGE_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for running median for large set of values (up to 2^32 - 1)
+///
+/// It keeps values in order of appearance (a ring) and two heaps of ring slots:
+/// a max-heap with the lower half of values and a min-heap with the upper half.
+/// Every slot knows its place at heaps, so the oldest value is replaced in place
+/// and the heaps are restored with sifting, so Add() is O(log N).
+/// The lower heap always has the same count of values as the upper one or one more.
+///
+/// LockPolicy and ErrorPolicy are the same as for Runmedian.
+///
+/// @note object is big for big kSize, so do not place it on stack.
+template <typename TRMValueType, const uint32_t kSize, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class RunmedianLarge : private LockPolicy, private ErrorPolicy {
+  public:
+    RunmedianLarge() = default;
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(kSize > 0U && kSize < 0x80000000U, "kSize must be in range 1..2^31-1");
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief Returns a size of values set, being used for calculating running median.
+     */
+    uint32_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values.
+     *
+     * @param container another value for calculating running median.
+     */
+    void Add(TRMValueType container);
+
+    /**
+     * @brief Adds a number of values under one lock, optionally with running median after every value.
+     *
+     * @param data values for calculating running median.
+     * @param count count of values.
+     * @param medians_out if not nullptr, receives running median after every value (count items).
+     */
+    void AddBatch(const TRMValueType* data, size_t count, TRMValueType* medians_out = nullptr);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks heaps order and slots positions
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    static constexpr uint32_t kHalf = (kSize + 1U) / 2U;
+    static constexpr uint32_t kHighHeap = 0x80000000U; // marks slot placed at the upper heap
+
+    void PlaceLow(uint32_t pos, uint32_t slot);
+    void PlaceHigh(uint32_t pos, uint32_t slot);
+    void SiftUpLow(uint32_t pos);
+    void SiftDownLow(uint32_t pos);
+    void SiftUpHigh(uint32_t pos);
+    void SiftDownHigh(uint32_t pos);
+    void PushLow(uint32_t slot);
+    void PushHigh(uint32_t slot);
+    uint32_t PopLow();
+    uint32_t PopHigh();
+    void Insert(uint32_t slot);
+    void Replace(uint32_t slot);
+    void Push(TRMValueType val);
+    TRMValueType Median() const;
+
+    TRMValueType values_[kSize]{}; // values in order of appearance
+    uint32_t low_[kHalf]{};        // max-heap of slots with the lower half of values
+    uint32_t high_[kHalf]{};       // min-heap of slots with the upper half of values
+    uint32_t where_[kSize]{};      // slot position at heap, kHighHeap bit for the upper heap
+    uint32_t head_{};              // the oldest slot, when all slots are used
+    uint32_t low_count_{};
+    uint32_t high_count_{};
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianlarge.inl"
+
+// RUNMEDIANLARGE_END
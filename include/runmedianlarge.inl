@@ -0,0 +1,296 @@
+// RUNMEDIANLARGE_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianlarge.hpp"
+
+namespace common {
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PlaceLow(uint32_t pos, uint32_t slot) {
+    low_[pos] = slot;
+    where_[slot] = pos;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PlaceHigh(uint32_t pos, uint32_t slot) {
+    high_[pos] = slot;
+    where_[slot] = pos | kHighHeap;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::SiftUpLow(uint32_t pos) {
+    const uint32_t slot = low_[pos];
+    while (pos > 0U) {
+        const uint32_t parent = (pos - 1U) >> 1;
+        if (!(values_[low_[parent]] < values_[slot]))
+            break;
+        PlaceLow(pos, low_[parent]);
+        pos = parent;
+    }
+    PlaceLow(pos, slot);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::SiftDownLow(uint32_t pos) {
+    const uint32_t slot = low_[pos];
+    for (;;) {
+        uint32_t child = (pos << 1) + 1U;
+        if (child >= low_count_)
+            break;
+        if (child + 1U < low_count_ && values_[low_[child]] < values_[low_[child + 1U]])
+            child++;
+        if (!(values_[slot] < values_[low_[child]]))
+            break;
+        PlaceLow(pos, low_[child]);
+        pos = child;
+    }
+    PlaceLow(pos, slot);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::SiftUpHigh(uint32_t pos) {
+    const uint32_t slot = high_[pos];
+    while (pos > 0U) {
+        const uint32_t parent = (pos - 1U) >> 1;
+        if (!(values_[slot] < values_[high_[parent]]))
+            break;
+        PlaceHigh(pos, high_[parent]);
+        pos = parent;
+    }
+    PlaceHigh(pos, slot);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::SiftDownHigh(uint32_t pos) {
+    const uint32_t slot = high_[pos];
+    for (;;) {
+        uint32_t child = (pos << 1) + 1U;
+        if (child >= high_count_)
+            break;
+        if (child + 1U < high_count_ && values_[high_[child + 1U]] < values_[high_[child]])
+            child++;
+        if (!(values_[high_[child]] < values_[slot]))
+            break;
+        PlaceHigh(pos, high_[child]);
+        pos = child;
+    }
+    PlaceHigh(pos, slot);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PushLow(uint32_t slot) {
+    PlaceLow(low_count_, slot);
+    low_count_++;
+    SiftUpLow(low_count_ - 1U);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PushHigh(uint32_t slot) {
+    PlaceHigh(high_count_, slot);
+    high_count_++;
+    SiftUpHigh(high_count_ - 1U);
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PopLow() {
+    const uint32_t top = low_[0];
+    low_count_--;
+    if (low_count_ > 0U) {
+        PlaceLow(0U, low_[low_count_]);
+        SiftDownLow(0U);
+    }
+    return top;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::PopHigh() {
+    const uint32_t top = high_[0];
+    high_count_--;
+    if (high_count_ > 0U) {
+        PlaceHigh(0U, high_[high_count_]);
+        SiftDownHigh(0U);
+    }
+    return top;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Insert(uint32_t slot) {
+    const TRMValueType val = values_[slot];
+    if (low_count_ == high_count_) {
+        // the lower heap gets one more value
+        if (high_count_ > 0U && values_[high_[0]] < val) {
+            PushLow(PopHigh());
+            PushHigh(slot);
+        } else {
+            PushLow(slot);
+        }
+    } else {
+        // the upper heap gets one more value
+        if (val < values_[low_[0]]) {
+            PushHigh(PopLow());
+            PushLow(slot);
+        } else {
+            PushHigh(slot);
+        }
+    }
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Replace(uint32_t slot) {
+    // the slot already has new value, restore its own heap first
+    const uint32_t pos = where_[slot] & ~kHighHeap;
+    if (where_[slot] & kHighHeap) {
+        SiftUpHigh(pos);
+        SiftDownHigh(where_[slot] & ~kHighHeap);
+    } else {
+        SiftUpLow(pos);
+        SiftDownLow(where_[slot]);
+    }
+
+    // only one value may cross the median, so one exchange of tops is enough
+    if (high_count_ > 0U && values_[high_[0]] < values_[low_[0]]) {
+        const uint32_t low_top = low_[0];
+        PlaceLow(0U, high_[0]);
+        PlaceHigh(0U, low_top);
+        SiftDownLow(0U);
+        SiftDownHigh(0U);
+    }
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Size() const {
+    return low_count_ + high_count_;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return low_count_ == 0U;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb, LockCb lock_cb,
+                                                                                     UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Median() const {
+    TRMValueType retval{};
+
+    if (low_count_ > high_count_) {
+        retval = values_[low_[0]];
+    } else if (low_count_ > 0U) {
+        retval = detail::Midpoint(values_[low_[0]], values_[high_[0]]);
+    }
+
+    return retval;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Value() const {
+    TRMValueType retval{};
+
+    HANDLE_ERROR(low_count_ <= kHalf && high_count_ <= low_count_, retval);
+
+    CONTAINER_LOCK();
+    retval = Median();
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::_check_integrity() {
+    const uint32_t count = low_count_ + high_count_;
+    if (count > kSize || high_count_ > low_count_ || low_count_ > high_count_ + 1U)
+        return false;
+
+    uint32_t i;
+    for (i = 0; i < low_count_; i++) {
+        if (where_[low_[i]] != i)
+            return false;
+        if (i > 0U && values_[low_[(i - 1U) >> 1]] < values_[low_[i]])
+            return false;
+    }
+    for (i = 0; i < high_count_; i++) {
+        if (where_[high_[i]] != (i | kHighHeap))
+            return false;
+        if (i > 0U && values_[high_[i]] < values_[high_[(i - 1U) >> 1]])
+            return false;
+    }
+    if (high_count_ > 0U && values_[high_[0]] < values_[low_[0]])
+        return false;
+
+    return true;
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Push(TRMValueType val) {
+    const uint32_t count = low_count_ + high_count_;
+
+    if (count < kSize) {
+        // nothing to erase, slots are used from 0 to kSize
+        values_[count] = val;
+        Insert(count);
+    } else {
+        // replace the oldest value
+        const uint32_t slot = head_;
+        head_ = (head_ + 1U == kSize) ? 0U : head_ + 1U;
+        values_[slot] = val;
+        Replace(slot);
+    }
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Add(TRMValueType val) {
+    HANDLE_ERRORV(low_count_ + high_count_ <= kSize);
+
+    CONTAINER_LOCK();
+    Push(val);
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::AddBatch(const TRMValueType* data, size_t count,
+                                                                            TRMValueType* medians_out) {
+    HANDLE_ERRORV(low_count_ + high_count_ <= kSize && (data != nullptr || count == 0U));
+
+    CONTAINER_LOCK();
+    if (medians_out != nullptr) {
+        for (size_t i = 0; i < count; i++) {
+            Push(data[i]);
+            medians_out[i] = Median();
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            Push(data[i]);
+        }
+    }
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint32_t kSize, typename LockPolicy, typename ErrorPolicy>
+void RunmedianLarge<TRMValueType, kSize, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    low_count_ = 0U;
+    high_count_ = 0U;
+    head_ = 0U;
+    CONTAINER_UNLOCK();
+}
+
+} // namespace common
+
+// RUNMEDIANLARGE_INL
@@ -0,0 +1,243 @@
+// RUNMEDIANREGISTRY_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdbool.h>
+#include <type_traits>
+#include <utility>
+
+namespace common {
+
+namespace detail {
+
+/**
+ * @brief Mixes bits of an integral key (murmur3 finalizer), low bits index a table, high bits choose a shard.
+ */
+template <typename TKey> uint64_t KeyHash(TKey key);
+
+/**
+ * @brief Returns the least power of two, which is not less than count.
+ */
+constexpr uint32_t TableSize(uint32_t count);
+
+} // namespace detail
+
+/// @brief Class for running medians of channels, which come and go, by a key (connection, device id)
+///
+/// Channels live at a slab of kCapacity Runmedian engines, there is no allocation per key: a new key takes
+/// a free slot and a removed or expired key gives it back. Keys are found by an open addressing table with
+/// linear probing, a table entry has the key and its slot, so a probe does not touch the slab.
+/// Deletion shifts the following entries back, there are no tombstones and probe chains stay short.
+/// Slots are linked in order of the last Add() (least recently used first), so Expire() reclaims channels
+/// idle for ttl or longer from the head of the list without a pass over the slab.
+/// A new key takes the least recently used channel when all slots are used, if it is idle for ttl already,
+/// otherwise it is an error.
+///
+/// Timestamps are ticks of a free running unsigned counter, as for RunmedianTimed. A timestamp earlier than
+/// the last one is taken as the last one, so producers with their own clocks may share a registry.
+/// LockPolicy and ErrorPolicy are the same as for Runmedian, one lock is taken for a whole call.
+///
+/// @note object is big for big kCapacity, so do not place it on stack.
+template <typename TRMValueType, const uint8_t kSize, const uint32_t kCapacity, typename TKey = uint32_t,
+          typename TTime = uint32_t, typename LockPolicy = CallbackLock, typename ErrorPolicy = CallbackError>
+class RunmedianRegistry : private LockPolicy, private ErrorPolicy {
+  public:
+    explicit RunmedianRegistry(TTime ttl);
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(std::is_integral<TKey>::value, "TKey must be integral");
+    static_assert(std::is_integral<TTime>::value && std::is_unsigned<TTime>::value, "TTime must be unsigned integral");
+    static_assert(kCapacity > 0U && kCapacity <= 0x40000000U, "kCapacity must be in range 1..2^30");
+
+    using Engine = Runmedian<TRMValueType, kSize, NoLock, IgnoreError>;
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value of a channel, it is an error if there is no such key.
+     *
+     * @param key key of the channel.
+     */
+    TRMValueType Value(TKey key) const;
+
+    /**
+     * @brief Returns a size of values set of a channel, 0 if there is no such key.
+     *
+     * @param key key of the channel.
+     */
+    uint8_t Size(TKey key) const;
+
+    /**
+     * @brief checks that there is a channel with the key
+     */
+    bool Contains(TKey key) const;
+
+    /**
+     * @brief Returns a count of channels.
+     */
+    uint32_t Count() const;
+
+    /**
+     * @brief Adds an object to set of values of a channel, the channel is created for a new key.
+     *
+     * @param key key of the channel.
+     * @param container another value for calculating running median.
+     * @param now current time, the channel is not idle at this time.
+     */
+    void Add(TKey key, TRMValueType container, TTime now);
+
+    /**
+     * @brief Deletes a channel, its slot is free for a new key.
+     *
+     * @param key key of the channel.
+     * @return false if there is no such key.
+     */
+    bool Remove(TKey key);
+
+    /**
+     * @brief Deletes channels without values for ttl or longer at the moment now.
+     *
+     * @param now current time.
+     * @return count of deleted channels.
+     */
+    uint32_t Expire(TTime now);
+
+    /**
+     * @brief Deletes all channels.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks that table and slots have the same keys, lists of used and free slots and all engines
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    static constexpr uint32_t kTable = detail::TableSize(kCapacity * 2U);
+    static constexpr uint32_t kNone = 0xFFFFFFFFU;
+
+    /// @brief Entry of the open addressing table.
+    struct Entry {
+        TKey key;
+        uint32_t slot; // kNone for an empty entry
+    };
+
+    TTime Advance(TTime now);
+    uint32_t Find(TKey key) const;
+    void Erase(uint32_t entry);
+    void Link(uint32_t slot);
+    void Unlink(uint32_t slot);
+    uint32_t Take(TKey key, TTime now);
+    void Release(uint32_t slot);
+    void Reset();
+
+    Entry table_[kTable];       // open addressing index, key -> slot
+    Engine engines_[kCapacity]; // slab of channels
+    TKey keys_[kCapacity];      // key of a used slot
+    TTime last_[kCapacity];     // time of the last Add() of a used slot
+    uint32_t older_[kCapacity]; // used slots from the least recently used one, kNone at the end
+    uint32_t newer_[kCapacity]; // used slots to the most recently used one, free slots by a list
+    uint32_t oldest_;           // the least recently used slot
+    uint32_t newest_;           // the most recently used slot
+    uint32_t free_;             // the first free slot
+    uint32_t count_;            // count of used slots
+    TTime clock_;               // the latest timestamp
+    TTime ttl_;
+};
+
+/// @brief Keyed running medians for concurrent ingest: kShards registries, each with its own lock.
+///
+/// A key always goes to the same shard (high bits of its hash), threads with different keys take different
+/// locks mostly, there is no global lock. Shards are cache line aligned, so their locks are not shared.
+/// kCapacity is the capacity of one shard. SpinLock is the default, as every call is short.
+///
+/// @note object is big for big kCapacity, so do not place it on stack.
+template <typename TRMValueType, const uint8_t kSize, const uint32_t kCapacity, const uint32_t kShards,
+          typename TKey = uint32_t, typename TTime = uint32_t, typename LockPolicy = SpinLock,
+          typename ErrorPolicy = IgnoreError>
+class RunmedianRegistrySharded {
+  public:
+    explicit RunmedianRegistrySharded(TTime ttl);
+    static_assert(kShards > 0U, "kShards must be positive");
+
+    using Registry = RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>;
+
+    /*
+     * @brief registers the same callbacks for every shard (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value of a channel, see RunmedianRegistry::Value().
+     */
+    TRMValueType Value(TKey key) const;
+
+    /**
+     * @brief Returns a size of values set of a channel, 0 if there is no such key.
+     */
+    uint8_t Size(TKey key) const;
+
+    /**
+     * @brief checks that there is a channel with the key
+     */
+    bool Contains(TKey key) const;
+
+    /**
+     * @brief Returns a count of channels of all shards, shards are locked one by one.
+     */
+    uint32_t Count() const;
+
+    /**
+     * @brief Adds an object to set of values of a channel, only the shard of the key is locked.
+     */
+    void Add(TKey key, TRMValueType container, TTime now);
+
+    /**
+     * @brief Deletes a channel, see RunmedianRegistry::Remove().
+     */
+    bool Remove(TKey key);
+
+    /**
+     * @brief Deletes idle channels of all shards, shards are locked one by one.
+     *
+     * @return count of deleted channels.
+     */
+    uint32_t Expire(TTime now);
+
+    /**
+     * @brief Deletes all channels.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks every shard
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    /// @brief Registry padded to its own cache lines.
+    struct alignas(64) Shard {
+        explicit Shard(TTime ttl) : registry(ttl) {}
+        Registry registry;
+    };
+
+    static uint32_t ShardOf(TKey key);
+    static Shard MakeShard(TTime ttl, size_t index);
+    template <size_t... kIndex> static std::array<Shard, kShards> MakeShards(TTime ttl, std::index_sequence<kIndex...>);
+
+    std::array<Shard, kShards> shards_;
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianregistry.inl"
+
+// RUNMEDIANREGISTRY_END
@@ -0,0 +1,462 @@
+// RUNMEDIANREGISTRY_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianregistry.hpp"
+#include <limits>
+
+namespace common {
+
+namespace detail {
+
+template <typename TKey> uint64_t KeyHash(TKey key) {
+    uint64_t hash = (uint64_t)key;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+constexpr uint32_t TableSize(uint32_t count) {
+    uint32_t size = 1U;
+    while (size < count) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // namespace detail
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::RunmedianRegistry(TTime ttl)
+    : ttl_(ttl) {
+    Reset();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::RegisterCallbacks(
+    ErrorCb error_cb, LockCb lock_cb, UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Reset() {
+    for (uint32_t i = 0; i < kTable; i++) {
+        table_[i] = Entry{TKey{}, kNone};
+    }
+    // free slots are linked by newer_
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        keys_[i] = TKey{};
+        last_[i] = 0;
+        older_[i] = kNone;
+        newer_[i] = i + 1U < kCapacity ? i + 1U : kNone;
+    }
+    oldest_ = kNone;
+    newest_ = kNone;
+    free_ = 0;
+    count_ = 0;
+    clock_ = 0;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+TTime RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Advance(TTime now) {
+    // the counter wraps, so now is earlier than the clock, if it is behind by less than a half of the range
+    if (count_ == 0U || (TTime)(now - clock_) <= std::numeric_limits<TTime>::max() / 2U) {
+        clock_ = now;
+    }
+    return clock_;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+uint32_t RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Find(TKey key) const {
+    for (uint32_t i = (uint32_t)detail::KeyHash(key) & (kTable - 1U); table_[i].slot != kNone;
+         i = (i + 1U) & (kTable - 1U)) {
+        if (table_[i].key == key)
+            return i;
+    }
+    return kNone;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Erase(uint32_t entry) {
+    // an entry after the hole moves to it, if the hole is between its home and its place,
+    // so every entry stays reachable from its home without tombstones
+    uint32_t hole = entry;
+    for (uint32_t i = (hole + 1U) & (kTable - 1U); table_[i].slot != kNone; i = (i + 1U) & (kTable - 1U)) {
+        const uint32_t home = (uint32_t)detail::KeyHash(table_[i].key) & (kTable - 1U);
+        if (((i - home) & (kTable - 1U)) >= ((i - hole) & (kTable - 1U))) {
+            table_[hole] = table_[i];
+            hole = i;
+        }
+    }
+    table_[hole].slot = kNone;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Link(uint32_t slot) {
+    older_[slot] = newest_;
+    newer_[slot] = kNone;
+    if (newest_ != kNone) {
+        newer_[newest_] = slot;
+    } else {
+        oldest_ = slot;
+    }
+    newest_ = slot;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Unlink(uint32_t slot) {
+    if (older_[slot] != kNone) {
+        newer_[older_[slot]] = newer_[slot];
+    } else {
+        oldest_ = newer_[slot];
+    }
+    if (newer_[slot] != kNone) {
+        older_[newer_[slot]] = older_[slot];
+    } else {
+        newest_ = older_[slot];
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+uint32_t RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Take(TKey key,
+                                                                                                      TTime now) {
+    // all slots are used: the least recently used channel is reclaimed, if it is idle
+    if (free_ == kNone) {
+        if ((TTime)(now - last_[oldest_]) < ttl_)
+            return kNone;
+        Release(oldest_);
+    }
+
+    const uint32_t slot = free_;
+    free_ = newer_[slot];
+    keys_[slot] = key;
+    engines_[slot].Clear();
+    last_[slot] = now;
+    Link(slot);
+    count_++;
+
+    uint32_t i = (uint32_t)detail::KeyHash(key) & (kTable - 1U);
+    while (table_[i].slot != kNone) {
+        i = (i + 1U) & (kTable - 1U);
+    }
+    table_[i] = Entry{key, slot};
+
+    return slot;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Release(uint32_t slot) {
+    const uint32_t entry = Find(keys_[slot]);
+    if (entry != kNone) {
+        Erase(entry);
+    }
+    Unlink(slot);
+    older_[slot] = kNone;
+    newer_[slot] = free_;
+    free_ = slot;
+    count_--;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+TRMValueType RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Value(
+    TKey key) const {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    const uint32_t entry = Find(key);
+    if (entry != kNone) {
+        retval = engines_[table_[entry].slot].Value();
+    }
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERROR(entry != kNone, retval);
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+uint8_t RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Size(TKey key) const {
+    uint8_t retval = 0;
+
+    CONTAINER_LOCK();
+    const uint32_t entry = Find(key);
+    if (entry != kNone) {
+        retval = engines_[table_[entry].slot].Size();
+    }
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+bool RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Contains(
+    TKey key) const {
+    CONTAINER_LOCK();
+    const bool retval = Find(key) != kNone;
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+uint32_t RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Count() const {
+    CONTAINER_LOCK();
+    const uint32_t retval = count_;
+    CONTAINER_UNLOCK();
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Add(TKey key,
+                                                                                                 TRMValueType val,
+                                                                                                 TTime now) {
+    CONTAINER_LOCK();
+    const TTime time = Advance(now);
+    const uint32_t entry = Find(key);
+    const uint32_t slot = entry != kNone ? table_[entry].slot : Take(key, time);
+    if (slot != kNone) {
+        engines_[slot].Add(val);
+        last_[slot] = time;
+        if (slot != newest_) {
+            Unlink(slot);
+            Link(slot);
+        }
+    }
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERRORV(slot != kNone);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+bool RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Remove(TKey key) {
+    CONTAINER_LOCK();
+    const uint32_t entry = Find(key);
+    if (entry != kNone) {
+        Release(table_[entry].slot);
+    }
+    CONTAINER_UNLOCK();
+
+    return entry != kNone;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+uint32_t RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Expire(TTime now) {
+    uint32_t expired = 0;
+
+    CONTAINER_LOCK();
+    const TTime time = Advance(now);
+    while (oldest_ != kNone && (TTime)(time - last_[oldest_]) >= ttl_) {
+        Release(oldest_);
+        expired++;
+    }
+    CONTAINER_UNLOCK();
+
+    return expired;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+void RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    Reset();
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, typename TKey, typename TTime, typename LockPolicy,
+          typename ErrorPolicy>
+bool RunmedianRegistry<TRMValueType, kSize, kCapacity, TKey, TTime, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (count_ > kCapacity)
+        return false;
+
+    // every entry is reachable from its home and points to a used slot with the same key
+    uint32_t entries = 0;
+    for (uint32_t i = 0; i < kTable; i++) {
+        if (table_[i].slot == kNone)
+            continue;
+        if (table_[i].slot >= kCapacity || keys_[table_[i].slot] != table_[i].key || Find(table_[i].key) != i)
+            return false;
+        entries++;
+    }
+    if (entries != count_)
+        return false;
+
+    // used slots from the least recently used one, times do not go back
+    uint32_t used = 0;
+    uint32_t prev = kNone;
+    for (uint32_t slot = oldest_; slot != kNone; slot = newer_[slot]) {
+        if (slot >= kCapacity || ++used > count_ || older_[slot] != prev || Find(keys_[slot]) == kNone)
+            return false;
+        if (prev != kNone && (TTime)(last_[slot] - last_[prev]) > std::numeric_limits<TTime>::max() / 2U)
+            return false;
+        if (!engines_[slot]._check_integrity())
+            return false;
+        prev = slot;
+    }
+    if (used != count_ || newest_ != prev)
+        return false;
+
+    uint32_t free = 0;
+    for (uint32_t slot = free_; slot != kNone; slot = newer_[slot]) {
+        if (slot >= kCapacity || ++free > kCapacity - count_)
+            return false;
+    }
+
+    return free == kCapacity - count_;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                         ErrorPolicy>::RunmedianRegistrySharded(TTime ttl)
+    : shards_(MakeShards(ttl, std::make_index_sequence<kShards>{})) {}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+typename RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::Shard
+RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::MakeShard(
+    TTime ttl, size_t index) {
+    (void)index;
+    return Shard(ttl);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+template <size_t... kIndex>
+std::array<typename RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                                             ErrorPolicy>::Shard,
+           kShards>
+RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::MakeShards(
+    TTime ttl, std::index_sequence<kIndex...>) {
+    // shards are not movable (locks), they are built in place from prvalues
+    return {{MakeShard(ttl, kIndex)...}};
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                                  ErrorPolicy>::ShardOf(TKey key) {
+    // tables of shards are indexed by low bits of the same hash
+    return (uint32_t)((detail::KeyHash(key) >> 32) % kShards);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+void RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                              ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb, LockCb lock_cb, UnlockCb unlock_cb) {
+    for (Shard& shard : shards_) {
+        shard.registry.RegisterCallbacks(error_cb, lock_cb, unlock_cb);
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                                      ErrorPolicy>::Value(TKey key) const {
+    return shards_[ShardOf(key)].registry.Value(key);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::Size(
+    TKey key) const {
+    return shards_[ShardOf(key)].registry.Size(key);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+bool RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                              ErrorPolicy>::Contains(TKey key) const {
+    return shards_[ShardOf(key)].registry.Contains(key);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                                  ErrorPolicy>::Count() const {
+    uint32_t count = 0;
+    for (const Shard& shard : shards_) {
+        count += shard.registry.Count();
+    }
+    return count;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+void RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::Add(
+    TKey key, TRMValueType val, TTime now) {
+    shards_[ShardOf(key)].registry.Add(key, val, now);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+bool RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::Remove(
+    TKey key) {
+    return shards_[ShardOf(key)].registry.Remove(key);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+uint32_t RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                                  ErrorPolicy>::Expire(TTime now) {
+    uint32_t expired = 0;
+    for (Shard& shard : shards_) {
+        expired += shard.registry.Expire(now);
+    }
+    return expired;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+void RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy, ErrorPolicy>::Clear() {
+    for (Shard& shard : shards_) {
+        shard.registry.Clear();
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kCapacity, uint32_t kShards, typename TKey, typename TTime,
+          typename LockPolicy, typename ErrorPolicy>
+bool RunmedianRegistrySharded<TRMValueType, kSize, kCapacity, kShards, TKey, TTime, LockPolicy,
+                              ErrorPolicy>::_check_integrity() {
+    for (Shard& shard : shards_) {
+        if (!shard.registry._check_integrity())
+            return false;
+    }
+    return true;
+}
+
+} // namespace common
+
+// RUNMEDIANREGISTRY_INL
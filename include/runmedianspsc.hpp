@@ -0,0 +1,84 @@
+// RUNMEDIANSPSC_HPP
+#pragma once
+
+#include "rqueuespsc.hpp"
+#include "runmedian.hpp"
+#include <atomic>
+#include <cstdint>
+#include <stdbool.h>
+#include <thread>
+
+namespace common {
+
+/// @brief Consistent pair of running median and size of values set.
+template <typename TRMValueType> struct RunmedianSnapshot {
+    TRMValueType median;
+    uint8_t size;
+};
+
+/// @brief Running median for one producer thread and any count of reader threads without locks.
+///
+/// The producer pushes values to a lock-free queue (Push), the consumer thread moves pending values
+/// to the running median and publishes the result (Update). Readers get the last published median
+/// and size through a sequence lock (Value, Snapshot): a reader never blocks the producer or the consumer,
+/// it only retries if the consumer is publishing at the same moment.
+template <typename TRMValueType, const uint8_t kSize, const uint32_t kQueueSize = 256U> class RunmedianSpsc {
+  public:
+    RunmedianSpsc() = default;
+    static_assert(std::atomic<TRMValueType>::is_always_lock_free, "TRMValueType must be lock free atomic");
+
+    /**
+     * @brief Adds a value to the pending queue. Producer thread only.
+     *
+     * @param container another value for calculating running median.
+     * @return false if the queue is full and the value is dropped.
+     */
+    bool Push(TRMValueType container);
+
+    /**
+     * @brief Moves all pending values to the running median and publishes it. Consumer thread only.
+     *
+     * @return running median value after the update.
+     */
+    TRMValueType Update();
+
+    /**
+     * @brief Last published running median value. Any thread.
+     */
+    TRMValueType Value() const;
+
+    /**
+     * @brief Last published running median value and size of values set. Any thread.
+     * It spins while the consumer is publishing and yields the CPU after kSpinsBeforeYield tries.
+     */
+    RunmedianSnapshot<TRMValueType> Snapshot() const;
+
+    /**
+     * @brief Returns a count of values, waiting for Update().
+     */
+    uint32_t Pending() const;
+
+    /**
+     * @brief Deletes all objects. Not thread safe.
+     */
+    void Clear();
+
+  private:
+    static constexpr uint32_t kSpinsBeforeYield = 64U;
+
+    void Publish(TRMValueType median, uint8_t size);
+
+    RqueueSpsc<TRMValueType, kQueueSize> pending_{};
+    Runmedian<TRMValueType, kSize, NoLock, IgnoreError> median_{}; // consumer thread only
+
+    alignas(64) std::atomic<uint32_t> sequence_{0U}; // odd while the consumer is publishing
+    std::atomic<TRMValueType> published_median_{};
+    std::atomic<uint8_t> published_size_{0U};
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianspsc.inl"
+
+// RUNMEDIANSPSC_END
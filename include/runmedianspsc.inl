@@ -0,0 +1,88 @@
+// RUNMEDIANSPSC_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianspsc.hpp"
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+bool RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Push(TRMValueType val) {
+    return pending_.TryPush(val);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+void RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Publish(TRMValueType median, uint8_t size) {
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+
+    sequence_.store(sequence + 1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    published_median_.store(median, std::memory_order_relaxed);
+    published_size_.store(size, std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2U, std::memory_order_release);
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+TRMValueType RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Update() {
+    TRMValueType batch[64];
+    uint32_t count = 0;
+    bool updated = false;
+
+    while ((count = pending_.PopN(batch, (uint32_t)(sizeof(batch) / sizeof(batch[0])))) > 0U) {
+        median_.AddBatch(batch, count);
+        updated = true;
+    }
+
+    const TRMValueType median = median_.Value();
+    if (updated) {
+        Publish(median, median_.Size());
+    }
+
+    return median;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+RunmedianSnapshot<TRMValueType> RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Snapshot() const {
+    RunmedianSnapshot<TRMValueType> snapshot{};
+
+    for (uint32_t tries = 1U;; tries++) {
+        const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+        if ((sequence & 1U) == 0U) {
+            snapshot.median = published_median_.load(std::memory_order_relaxed);
+            snapshot.size = published_size_.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence)
+                break;
+        }
+
+        // the consumer is publishing right now, it may be preempted in the middle, so do not burn the core
+        if (tries % kSpinsBeforeYield == 0U)
+            std::this_thread::yield();
+    }
+
+    return snapshot;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+TRMValueType RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Value() const {
+    return Snapshot().median;
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+uint32_t RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Pending() const {
+    return pending_.Size();
+}
+
+template <typename TRMValueType, uint8_t kSize, uint32_t kQueueSize>
+void RunmedianSpsc<TRMValueType, kSize, kQueueSize>::Clear() {
+    pending_.DeleteAll();
+    median_.Clear();
+    Publish(TRMValueType{}, 0U);
+}
+
+} // namespace common
+
+// RUNMEDIANSPSC_INL
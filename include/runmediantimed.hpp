@@ -0,0 +1,110 @@
+// RUNMEDIANTIMED_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdbool.h>
+#include <type_traits>
+
+namespace common {
+
+/// @brief Class for running median of values with timestamps, over the last horizon of time
+///
+/// It is Runmedian with a timestamp for every value: values older than the horizon are deleted
+/// by Add() and Value(now), all of them with one pass over the sorted array from the lowest expired position,
+/// however many they are. A burst of expiries is cheaper than deleting values one by one for middle windows
+/// (about 20% per value at kSize 64 with bursts of kSize / 2, RunMedianBench TimedBursts), less so for big ones,
+/// where the insert of every value is the most of the cost (about 10% at 255), and not at all for small ones.
+/// Values are kept in order of appearance (a ring) with a position at the sorted array for every slot,
+/// the oldest values are at the head of the ring, so expired values are found without search.
+/// There are at most kSize values, when the window is full the oldest value is deleted as in Runmedian.
+///
+/// Timestamps are ticks of a free running unsigned counter (milliseconds, for example), they are compared
+/// as differences, so the counter may wrap around. A value is kept while now - timestamp < horizon.
+/// LockPolicy and ErrorPolicy are the same as for Runmedian, a timestamp earlier than the last one is an error.
+template <typename TRMValueType, const uint8_t kSize, typename TTime = uint32_t, typename LockPolicy = CallbackLock,
+          typename ErrorPolicy = CallbackError>
+class RunmedianTimed : private LockPolicy, private ErrorPolicy {
+  public:
+    explicit RunmedianTimed(TTime horizon) : horizon_(horizon) {}
+    static_assert(std::is_arithmetic<TRMValueType>::value, "TRMValueType must be numeric");
+    static_assert(std::is_integral<TTime>::value && std::is_unsigned<TTime>::value, "TTime must be unsigned integral");
+    static_assert(kSize > 0U, "kSize must be in range 1..255");
+
+    /*
+     * @brief if you need to use lock function for multithreading and error handling (callback policies only)
+     */
+    void RegisterCallbacks(ErrorCb error_cb = nullptr, LockCb lock_cb = nullptr, UnlockCb unlock_cb = nullptr);
+
+    /**
+     * @brief running median value of values not older than the horizon at the moment now.
+     *
+     * @param now current time, not earlier than timestamp of the last value.
+     */
+    TRMValueType Value(TTime now);
+
+    /**
+     * @brief Deletes values older than the horizon at the moment now.
+     *
+     * @param now current time, not earlier than timestamp of the last value.
+     * @return count of deleted values.
+     */
+    uint8_t Expire(TTime now);
+
+    /**
+     * @brief Returns a size of values set, including values, which are expired, but not deleted yet.
+     */
+    uint8_t Size() const;
+
+    /**
+     * @brief checks that we have at least one value for calculating median
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Adds an object to set of values, deletes values older than the horizon at its timestamp.
+     *
+     * @param container another value for calculating running median.
+     * @param timestamp time of the value, not earlier than timestamp of the previous value.
+     */
+    void Add(TRMValueType container, TTime timestamp);
+
+    /**
+     * @brief Deletes all objects from the set of values.
+     */
+    void Clear();
+
+    /**
+     * @brief Checks that array is sorted, order of appearance index is consistent and timestamps are ordered
+     * @note for unit tests only! CPU bound function
+     */
+    bool _check_integrity();
+
+  private:
+    // window shorter than one 16 bytes vector is searched by scalar code
+    static constexpr bool kVectorSearch = kSize * sizeof(TRMValueType) >= 16U;
+
+    bool IsEarlier(TTime timestamp) const;
+    uint8_t Slot(uint32_t index) const;
+    uint8_t Evict(TTime now);
+    void EraseOldest();
+    bool Insert(TRMValueType val, TTime timestamp);
+    TRMValueType Median() const;
+
+    TRMValueType values_sorted[kSize]{}; // sorted from less to greater value
+    uint8_t values_order[kSize]{};       // position at values_sorted for every slot in order of appearance
+    TTime times_[kSize]{};               // timestamp for every slot
+    TTime horizon_;
+    TTime newest_{};      // timestamp of the last value
+    uint8_t values_count{};
+    uint8_t values_head{}; // slot of the oldest value
+};
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmediantimed.inl"
+
+// RUNMEDIANTIMED_END
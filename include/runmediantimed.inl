@@ -0,0 +1,243 @@
+// RUNMEDIANTIMED_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "rmsimd.hpp"
+#include "runmediantimed.hpp"
+
+#include <cstring>
+
+namespace common {
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+void RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::RegisterCallbacks(ErrorCb error_cb,
+                                                                                            LockCb lock_cb,
+                                                                                            UnlockCb unlock_cb) {
+    static_assert(LockPolicy::kCallbacks || ErrorPolicy::kCallbacks, "policies have no callbacks to register");
+
+    if constexpr (ErrorPolicy::kCallbacks) {
+        this->RegisterErrorCallback(error_cb);
+    } else {
+        (void)error_cb;
+    }
+    if constexpr (LockPolicy::kCallbacks) {
+        this->RegisterLockCallbacks(lock_cb, unlock_cb);
+    } else {
+        (void)lock_cb;
+        (void)unlock_cb;
+    }
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::IsEarlier(TTime timestamp) const {
+    // the counter may wrap around, so the half of its range before the last value is the past
+    const TTime back = (TTime)(newest_ - timestamp);
+    return values_count > 0U && back != 0U && back <= std::numeric_limits<TTime>::max() / 2U;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Slot(uint32_t index) const {
+    // slot of index-th value in order of appearance
+    const uint32_t slot = values_head + index;
+    return (uint8_t)(slot >= kSize ? slot - kSize : slot);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Evict(TTime now) {
+    // expired values are the oldest ones, they are at the head of the ring
+    uint32_t expired = 0;
+    while (expired < values_count && (TTime)(now - times_[Slot(expired)]) >= horizon_) {
+        expired++;
+    }
+
+    if (expired == 0U)
+        return 0U;
+
+    if (expired == values_count) {
+        values_count = 0;
+        values_head = 0;
+        return (uint8_t)expired;
+    }
+
+    // a steady rate expires one value per Add(), it is one move of the sorted array as in Runmedian
+    if (expired == 1U) {
+        EraseOldest();
+        return 1U;
+    }
+
+    // all expired values leave the sorted array with one pass, which also gives a new position for every old one;
+    // values below the lowest expired one keep their places, so the pass starts there
+    bool erased[kSize]{};
+    uint32_t first = kSize;
+    uint32_t i;
+    for (i = 0; i < expired; i++) {
+        const uint8_t pos = values_order[Slot(i)];
+        erased[pos] = true;
+        first = pos < first ? pos : first;
+    }
+
+    uint8_t moved[kSize]{};
+    uint32_t kept = first;
+    for (i = first; i < values_count; i++) {
+        moved[i] = (uint8_t)kept;
+        values_sorted[kept] = values_sorted[i];
+        kept += erased[i] ? 0U : 1U;
+    }
+
+    values_head = Slot(expired);
+    values_count = (uint8_t)kept;
+    for (i = 0; i < values_count; i++) {
+        const uint8_t slot = Slot(i);
+        const uint8_t pos = values_order[slot];
+        if (pos >= first)
+            values_order[slot] = moved[pos];
+    }
+
+    return (uint8_t)expired;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+void RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::EraseOldest() {
+    const uint32_t ierase = values_order[values_head];
+    memmove(values_sorted + ierase, values_sorted + ierase + 1, (values_count - ierase - 1U) * sizeof(TRMValueType));
+    simd::AddInRange(values_order, kSize, (uint8_t)(ierase + 1U), (uint8_t)(values_count - ierase - 1U), 0xFFU);
+    values_head = Slot(1U);
+    values_count--;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Insert(TRMValueType val, TTime timestamp) {
+    if (IsEarlier(timestamp))
+        return false;
+
+    Evict(timestamp);
+    if (values_count == kSize) {
+        EraseOldest();
+    }
+
+    // insert position is the count of values not greater than the new one (upper bound)
+    uint32_t igreater = 0;
+    if constexpr (kVectorSearch) {
+        igreater = simd::CountNotGreater(values_sorted, values_count, val);
+    } else {
+        igreater = simd::CountNotGreater<TRMValueType>(values_sorted, values_count, val);
+    }
+
+    memmove(values_sorted + igreater + 1, values_sorted + igreater, (values_count - igreater) * sizeof(TRMValueType));
+    values_sorted[igreater] = val;
+    simd::AddInRange(values_order, kSize, (uint8_t)igreater, (uint8_t)(values_count - igreater), 1U);
+
+    const uint8_t slot = Slot(values_count);
+    values_order[slot] = (uint8_t)igreater;
+    times_[slot] = timestamp;
+    newest_ = timestamp;
+    values_count++;
+
+    return true;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Median() const {
+    if (values_count == 0U) {
+        return TRMValueType{};
+    }
+
+    const uint8_t index = (uint8_t)((values_count - 1U) / 2U);
+    if constexpr (kSize > 1U) {
+        // even set exists for kSize > 1 only
+        if (values_count % 2U == 0U) {
+            return detail::Midpoint(values_sorted[index], values_sorted[index + 1U]);
+        }
+    }
+    return values_sorted[index];
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+TRMValueType RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Value(TTime now) {
+    TRMValueType retval{};
+
+    CONTAINER_LOCK();
+    const bool status = !IsEarlier(now);
+    if (status) {
+        Evict(now);
+    }
+    retval = Median();
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERROR(status, retval);
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Expire(TTime now) {
+    uint8_t retval = 0;
+
+    CONTAINER_LOCK();
+    const bool status = !IsEarlier(now);
+    if (status) {
+        retval = Evict(now);
+    }
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERROR(status, retval);
+
+    return retval;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+uint8_t RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Size() const {
+    return values_count;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::IsEmpty() const {
+    return values_count == 0U;
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+void RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Add(TRMValueType val, TTime timestamp) {
+    CONTAINER_LOCK();
+    const bool status = Insert(val, timestamp);
+    CONTAINER_UNLOCK();
+
+    HANDLE_ERRORV(status);
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+void RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::Clear() {
+    CONTAINER_LOCK();
+    memset(values_sorted, 0, sizeof(values_sorted));
+    memset(values_order, 0, sizeof(values_order));
+    memset(times_, 0, sizeof(times_));
+    newest_ = 0;
+    values_count = 0;
+    values_head = 0;
+    CONTAINER_UNLOCK();
+}
+
+template <typename TRMValueType, uint8_t kSize, typename TTime, typename LockPolicy, typename ErrorPolicy>
+bool RunmedianTimed<TRMValueType, kSize, TTime, LockPolicy, ErrorPolicy>::_check_integrity() {
+    if (values_count > kSize || values_head >= kSize)
+        return false;
+
+    bool used[kSize]{};
+    for (uint32_t i = 0; i < values_count; i++) {
+        if (i > 0U && values_sorted[i] < values_sorted[i - 1U])
+            return false;
+        // every position is used by one slot only
+        const uint8_t slot = Slot(i);
+        if (values_order[slot] >= values_count || used[values_order[slot]])
+            return false;
+        used[values_order[slot]] = true;
+        // timestamps do not decrease from the head to the last value
+        if ((TTime)(newest_ - times_[slot]) > (TTime)(newest_ - times_[Slot(0U)]))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace common
+
+// RUNMEDIANTIMED_INL
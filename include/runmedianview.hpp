@@ -0,0 +1,220 @@
+// RUNMEDIANVIEW_HPP
+#pragma once
+
+#include "runmedian.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if __has_include(<version>)
+#include <version>
+#endif
+
+// the view is for C++20 with ranges, it is nothing for older standards
+#if defined(__cpp_lib_ranges) && defined(__cpp_concepts)
+#define RUNMEDIAN_RANGES 1
+
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+// the generator needs coroutines of C++20 as well
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+#define RUNMEDIAN_COROUTINES 1
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#endif
+
+namespace common {
+
+/// @brief View of running medians of an input view: the i-th element is the running median after i + 1 values
+///
+/// The Runmedian engine lives inside the view, so there is no heap and no copy of values: every increment of
+/// the iterator adds one value of the input and takes the median, it is the same as a loop of Add() and Value().
+/// The view is a single pass (input) range, begin() starts from the empty window again.
+/// Engine has NoLock and IgnoreError policies, a view is used by one thread.
+///
+/// Usage: for (auto median : samples | std::views::transform(scale) | common::views::running_median<19>) ...
+template <std::ranges::input_range TView, const uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+class RunmedianView : public std::ranges::view_interface<RunmedianView<TView, kSize>> {
+  public:
+    using ValueType = std::ranges::range_value_t<TView>;
+    using Engine = Runmedian<ValueType, kSize, NoLock, IgnoreError>;
+
+    class Iterator {
+      public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = ValueType;
+        using difference_type = std::ranges::range_difference_t<TView>;
+
+        Iterator() = default;
+
+        /**
+         * @brief running median after the current value of the input
+         */
+        ValueType operator*() const;
+
+        Iterator& operator++();
+        void operator++(int);
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) { return it.current_ == it.end_; }
+
+      private:
+        friend class RunmedianView;
+
+        Iterator(Engine* engine, std::ranges::iterator_t<TView> current, std::ranges::sentinel_t<TView> end);
+        void Take();
+
+        Engine* engine_{};
+        std::ranges::iterator_t<TView> current_{};
+        std::ranges::sentinel_t<TView> end_{};
+        ValueType median_{};
+    };
+
+    RunmedianView() = default;
+    explicit RunmedianView(TView base);
+
+    /**
+     * @brief Clears the window and takes the first value of the input.
+     */
+    Iterator begin();
+    std::default_sentinel_t end() const;
+
+    /**
+     * @brief the input view
+     */
+    TView base() const;
+
+  private:
+    TView base_{};
+    Engine engine_{};
+};
+
+namespace views {
+
+/// @brief Range adaptor object: range | running_median<kSize> or running_median<kSize>(range)
+template <uint8_t kSize> struct RunningMedianAdaptor {
+    template <std::ranges::viewable_range TRange> auto operator()(TRange&& range) const;
+
+    template <std::ranges::viewable_range TRange>
+    friend auto operator|(TRange&& range, const RunningMedianAdaptor& adaptor) {
+        return adaptor(std::forward<TRange>(range));
+    }
+};
+
+template <uint8_t kSize> inline constexpr RunningMedianAdaptor<kSize> running_median{};
+
+} // namespace views
+
+#ifdef RUNMEDIAN_COROUTINES
+/// @brief Generator of running medians made by RunningMedians(), a single pass (input) range
+///
+/// The coroutine frame keeps the Runmedian engine and the source, it is allocated by the allocator given to
+/// RunningMedians() and nothing else allocates. The frame is released with the generator, begin() is called once.
+/// Sources must not throw, as engines do not, an exception of a source terminates.
+/// Every median is one resume of the coroutine, a few ns more than the view, use the view for ranges in hot loops.
+template <typename TRMValueType> class RunmedianGenerator {
+  public:
+    struct promise_type {
+        RunmedianGenerator get_return_object();
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        std::suspend_always yield_value(TRMValueType median) noexcept;
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        /**
+         * @brief Frame is allocated by the allocator of the coroutine, there is no other operator new,
+         * so a coroutine without std::allocator_arg does not compile.
+         */
+        template <typename TAlloc, typename... TArgs>
+        static void* operator new(size_t size, std::allocator_arg_t, const TAlloc& alloc, const TArgs&...);
+        static void operator delete(void* frame, size_t size);
+
+        TRMValueType median_{};
+    };
+
+    class Iterator {
+      public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = TRMValueType;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        /**
+         * @brief the last yielded median
+         */
+        TRMValueType operator*() const { return handle_.promise().median_; }
+
+        Iterator& operator++();
+        void operator++(int);
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) { return it.handle_.done(); }
+
+      private:
+        friend class RunmedianGenerator;
+
+        explicit Iterator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_{};
+    };
+
+    RunmedianGenerator(RunmedianGenerator&& other) noexcept;
+    RunmedianGenerator& operator=(RunmedianGenerator&& other) noexcept;
+    RunmedianGenerator(const RunmedianGenerator&) = delete;
+    RunmedianGenerator& operator=(const RunmedianGenerator&) = delete;
+    ~RunmedianGenerator();
+
+    /**
+     * @brief Runs the coroutine to the first median.
+     */
+    Iterator begin();
+    std::default_sentinel_t end() const;
+
+  private:
+    explicit RunmedianGenerator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_{};
+};
+
+namespace detail {
+
+// value type of a source: a range of values or a callable, which returns std::optional of the next value
+template <typename TSource> struct SourceValue {
+    using Type = typename std::invoke_result_t<TSource&>::value_type;
+};
+
+template <std::ranges::input_range TSource> struct SourceValue<TSource> {
+    using Type = std::ranges::range_value_t<TSource>;
+};
+
+} // namespace detail
+
+/**
+ * @brief Lazily yields the running median after every value of the source.
+ *
+ * The source is an input range, it is taken by std::views::all, or an async source: a callable, which returns
+ * std::optional of the next value and std::nullopt at the end, it may wait for the value inside.
+ *
+ * @param alloc allocator of the coroutine frame, e.g. of a fixed buffer, it is rebound to std::max_align_t.
+ * @param source range or callable of values.
+ *
+ * Usage: for (auto median : common::RunningMedians<19>(std::allocator_arg, arena, poll_adc)) ...
+ */
+template <uint8_t kSize, typename TAlloc, typename TSource>
+auto RunningMedians(std::allocator_arg_t, const TAlloc& alloc, TSource&& source);
+#endif // RUNMEDIAN_COROUTINES
+
+} // namespace common
+
+// Here comes the implementation.
+#include "runmedianview.inl"
+
+#endif // __cpp_lib_ranges
+
+// RUNMEDIANVIEW_END
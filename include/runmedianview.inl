@@ -0,0 +1,219 @@
+// RUNMEDIANVIEW_INL
+// As a compromise to have template implementation in separate file but still make it visible to a translation unit.
+#pragma once
+
+#include "runmedianview.hpp"
+
+namespace common {
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+RunmedianView<TView, kSize>::Iterator::Iterator(Engine* engine, std::ranges::iterator_t<TView> current,
+                                                std::ranges::sentinel_t<TView> end)
+    : engine_(engine), current_(std::move(current)), end_(std::move(end)) {
+    Take();
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+void RunmedianView<TView, kSize>::Iterator::Take() {
+    // the median is taken once per value, so operator*() is a copy
+    if (current_ != end_) {
+        engine_->Add((ValueType)*current_);
+        median_ = engine_->Value();
+    }
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+typename RunmedianView<TView, kSize>::ValueType RunmedianView<TView, kSize>::Iterator::operator*() const {
+    return median_;
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+typename RunmedianView<TView, kSize>::Iterator& RunmedianView<TView, kSize>::Iterator::operator++() {
+    ++current_;
+    Take();
+    return *this;
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+void RunmedianView<TView, kSize>::Iterator::operator++(int) {
+    ++*this;
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+RunmedianView<TView, kSize>::RunmedianView(TView base) : base_(std::move(base)) {}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+typename RunmedianView<TView, kSize>::Iterator RunmedianView<TView, kSize>::begin() {
+    engine_.Clear();
+    return Iterator(&engine_, std::ranges::begin(base_), std::ranges::end(base_));
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+std::default_sentinel_t RunmedianView<TView, kSize>::end() const {
+    return std::default_sentinel;
+}
+
+template <std::ranges::input_range TView, uint8_t kSize>
+    requires std::ranges::view<TView> && std::is_arithmetic_v<std::ranges::range_value_t<TView>>
+TView RunmedianView<TView, kSize>::base() const {
+    return base_;
+}
+
+namespace views {
+
+template <uint8_t kSize>
+template <std::ranges::viewable_range TRange>
+auto RunningMedianAdaptor<kSize>::operator()(TRange&& range) const {
+    return RunmedianView<std::views::all_t<TRange>, kSize>(std::views::all(std::forward<TRange>(range)));
+}
+
+} // namespace views
+
+#ifdef RUNMEDIAN_COROUTINES
+namespace detail {
+
+// frame is followed by the release function and the allocator, which has allocated it:
+// [frame][release][allocator], each part starts at a multiple of std::max_align_t
+using FrameBlock = std::max_align_t;
+using FrameRelease = void (*)(void* frame, size_t size);
+
+inline size_t FrameBlocks(size_t size) {
+    return (size + sizeof(FrameBlock) - 1U) / sizeof(FrameBlock);
+}
+
+template <typename TBlockAlloc> size_t FrameTotalBlocks(size_t size) {
+    static_assert(alignof(TBlockAlloc) <= alignof(FrameBlock), "allocator is over aligned");
+    static_assert(sizeof(FrameRelease) <= sizeof(FrameBlock), "release function does not fit a block");
+    return FrameBlocks(size) + 1U + FrameBlocks(sizeof(TBlockAlloc));
+}
+
+template <typename TBlockAlloc> void ReleaseFrame(void* frame, size_t size) {
+    FrameBlock* blocks = static_cast<FrameBlock*>(frame);
+    TBlockAlloc* stored = std::launder(reinterpret_cast<TBlockAlloc*>(blocks + FrameBlocks(size) + 1U));
+    TBlockAlloc alloc(std::move(*stored));
+    stored->~TBlockAlloc();
+    std::allocator_traits<TBlockAlloc>::deallocate(alloc, blocks, FrameTotalBlocks<TBlockAlloc>(size));
+}
+
+template <uint8_t kSize, typename TAlloc, typename TSource>
+RunmedianGenerator<typename SourceValue<TSource>::Type> MedianCoroutine(std::allocator_arg_t, TAlloc alloc,
+                                                                        TSource source) {
+    using ValueType = typename SourceValue<TSource>::Type;
+
+    // the allocator is a parameter for operator new of the frame only
+    (void)alloc;
+    Runmedian<ValueType, kSize, NoLock, IgnoreError> engine{};
+    if constexpr (std::ranges::input_range<TSource>) {
+        for (auto&& val : source) {
+            engine.Add((ValueType)val);
+            co_yield engine.Value();
+        }
+    } else {
+        for (std::optional<ValueType> val = source(); val.has_value(); val = source()) {
+            engine.Add(*val);
+            co_yield engine.Value();
+        }
+    }
+}
+
+} // namespace detail
+
+template <typename TRMValueType>
+RunmedianGenerator<TRMValueType> RunmedianGenerator<TRMValueType>::promise_type::get_return_object() {
+    return RunmedianGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+template <typename TRMValueType>
+std::suspend_always RunmedianGenerator<TRMValueType>::promise_type::yield_value(TRMValueType median) noexcept {
+    median_ = median;
+    return {};
+}
+
+template <typename TRMValueType>
+template <typename TAlloc, typename... TArgs>
+void* RunmedianGenerator<TRMValueType>::promise_type::operator new(size_t size, std::allocator_arg_t,
+                                                                   const TAlloc& alloc, const TArgs&...) {
+    using BlockAlloc = typename std::allocator_traits<TAlloc>::template rebind_alloc<detail::FrameBlock>;
+
+    BlockAlloc blocks_alloc(alloc);
+    detail::FrameBlock* blocks =
+        std::allocator_traits<BlockAlloc>::allocate(blocks_alloc, detail::FrameTotalBlocks<BlockAlloc>(size));
+    const size_t frame_blocks = detail::FrameBlocks(size);
+    new (blocks + frame_blocks) detail::FrameRelease(&detail::ReleaseFrame<BlockAlloc>);
+    new (blocks + frame_blocks + 1U) BlockAlloc(std::move(blocks_alloc));
+    return blocks;
+}
+
+template <typename TRMValueType>
+void RunmedianGenerator<TRMValueType>::promise_type::operator delete(void* frame, size_t size) {
+    detail::FrameBlock* blocks = static_cast<detail::FrameBlock*>(frame);
+    const detail::FrameRelease release =
+        *std::launder(reinterpret_cast<detail::FrameRelease*>(blocks + detail::FrameBlocks(size)));
+    release(frame, size);
+}
+
+template <typename TRMValueType>
+typename RunmedianGenerator<TRMValueType>::Iterator& RunmedianGenerator<TRMValueType>::Iterator::operator++() {
+    handle_.resume();
+    return *this;
+}
+
+template <typename TRMValueType> void RunmedianGenerator<TRMValueType>::Iterator::operator++(int) {
+    ++*this;
+}
+
+template <typename TRMValueType>
+RunmedianGenerator<TRMValueType>::RunmedianGenerator(RunmedianGenerator&& other) noexcept
+    : handle_(std::exchange(other.handle_, {})) {}
+
+template <typename TRMValueType>
+RunmedianGenerator<TRMValueType>& RunmedianGenerator<TRMValueType>::operator=(RunmedianGenerator&& other) noexcept {
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+}
+
+template <typename TRMValueType> RunmedianGenerator<TRMValueType>::~RunmedianGenerator() {
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+template <typename TRMValueType>
+typename RunmedianGenerator<TRMValueType>::Iterator RunmedianGenerator<TRMValueType>::begin() {
+    handle_.resume();
+    return Iterator(handle_);
+}
+
+template <typename TRMValueType> std::default_sentinel_t RunmedianGenerator<TRMValueType>::end() const {
+    return std::default_sentinel;
+}
+
+template <uint8_t kSize, typename TAlloc, typename TSource>
+auto RunningMedians(std::allocator_arg_t, const TAlloc& alloc, TSource&& source) {
+    // a range is kept as a view in the frame, an owning one for rvalues, a callable is copied
+    if constexpr (std::ranges::viewable_range<TSource>) {
+        return detail::MedianCoroutine<kSize>(std::allocator_arg, alloc,
+                                              std::views::all(std::forward<TSource>(source)));
+    } else {
+        return detail::MedianCoroutine<kSize>(std::allocator_arg, alloc,
+                                              std::decay_t<TSource>(std::forward<TSource>(source)));
+    }
+}
+#endif // RUNMEDIAN_COROUTINES
+
+} // namespace common
+
+// RUNMEDIANVIEW_INL